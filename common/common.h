@@ -3,6 +3,17 @@
 
 //#include <QMap>
 //#include <std::shared_ptr>
+#include <cstdint>
+#include <string>
+#include <time.h>
+#if defined(QT_CORE_LIB)
+#include <QPointF>
+#endif
+#if defined(QT_GUI_LIB)
+#include <QImage>
+#include <QSize>
+#include <QString>
+#endif
 
 #define BUTTONS_DEFINITIONS \
 BUTTON_DEF(X, 0) \
@@ -25,38 +36,152 @@ BUTTON_DEF(RIGHTSTICK, 16) \
 BUTTON_DEF(DPAD, 17) \
 BUTTON_DEF(COUNT, 18) \
 
+// Qt-free stand-in for QPointF, the driver and the wire format use it so they build without Qt
+struct PointF {
+    PointF(const double &x = 0, const double &y = 0): m_x(x), m_y(y) {}
+#if defined(QT_CORE_LIB)
+    PointF(const QPointF &point): m_x(point.x()), m_y(point.y()) {}
+#endif
+    double x() const { return m_x; }
+    double y() const { return m_y; }
+
+    double m_x;
+    double m_y;
+};
+
 enum Button {
 #define BUTTON_DEF(x, y) x = 1 << y,
 BUTTONS_DEFINITIONS
 #undef BUTTON_DEF
 };
 
-static inline std::string labelForButton(const Button &button) {
-    switch (button) {
-#define BUTTON_DEF(x, y) case x: return #x;
+// Tables generated from BUTTONS_DEFINITIONS, indexed by the button's bit position
+namespace ButtonTables {
+
+constexpr int Count = 0
+#define BUTTON_DEF(x, y) + 1
+BUTTONS_DEFINITIONS
+#undef BUTTON_DEF
+;
+
+constexpr const char *Labels[Count] = {
+#define BUTTON_DEF(x, y) #x,
+BUTTONS_DEFINITIONS
+#undef BUTTON_DEF
+};
+
+constexpr int Positions[Count] = {
+#define BUTTON_DEF(x, y) y,
 BUTTONS_DEFINITIONS
 #undef BUTTON_DEF
-        default: return "";
+};
+
+constexpr bool positionsAreSequential() {
+    for(int i = 0; i < Count; ++i) {
+        if(Positions[i] != i)
+            return false;
+    }
+    return true;
+}
+static_assert(positionsAreSequential(), "BUTTONS_DEFINITIONS must list bit positions 0, 1, 2... in order");
+
+// FNV-1a of the label, spread over the table by a seeded multiplicative step. The seed is searched
+// at compile time so every label lands in its own slot
+constexpr int HashBits = 6;
+constexpr int HashSize = 1 << HashBits;
+
+constexpr uint32_t labelHash(const char *label) {
+    uint32_t hash = 2166136261u;
+    for(; *label; ++label) {
+        hash ^= uint8_t(*label);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr uint32_t hashSlot(const uint32_t hash, const uint32_t seed) {
+    return ((hash ^ seed) * 2654435761u) >> (32 - HashBits);
+}
+
+constexpr bool seedIsPerfect(const uint32_t seed) {
+    bool used[HashSize] = {};
+    for(int i = 0; i < Count; ++i) {
+        const uint32_t slot = hashSlot(labelHash(Labels[i]), seed);
+        if(used[slot])
+            return false;
+        used[slot] = true;
     }
+    return true;
+}
+
+constexpr uint32_t findSeed() {
+    uint32_t seed = 0;
+    while(!seedIsPerfect(seed))
+        ++seed;
+    return seed;
+}
+
+constexpr uint32_t Seed = findSeed();
+
+struct HashTable {
+    int8_t slots[HashSize];
+};
+
+constexpr HashTable makeHashTable() {
+    HashTable table = {};
+    for(int i = 0; i < HashSize; ++i)
+        table.slots[i] = -1;
+    for(int i = 0; i < Count; ++i)
+        table.slots[hashSlot(labelHash(Labels[i]), Seed)] = int8_t(i);
+    return table;
+}
+
+constexpr HashTable LabelSlots = makeHashTable();
+
+} // namespace ButtonTables
+
+// Bit position of a single button, -1 for combinations and zero
+static inline int buttonIndex(const Button &button) {
+    const uint32_t bits = uint32_t(button);
+    if(bits == 0 || (bits & (bits - 1)))
+        return -1;
+    return __builtin_ctz(bits);
+}
+
+static inline const char *labelForButton(const Button &button) {
+    const int index = buttonIndex(button);
+    return index < 0 || index >= ButtonTables::Count ? "" : ButtonTables::Labels[index];
 }
 
 static inline Button buttonForLabel(const std::string &label) {
-#define BUTTON_DEF(x, y) if(#x == label) return Button(x);
-BUTTONS_DEFINITIONS
-#undef BUTTON_DEF
-    return Button::COUNT;
+    const int8_t index = ButtonTables::LabelSlots.slots[ButtonTables::hashSlot(ButtonTables::labelHash(label.c_str()), ButtonTables::Seed)];
+    if(index < 0 || label != ButtonTables::Labels[index])
+        return Button::COUNT;
+    return Button(1 << index);
+}
+
+// CLOCK_MONOTONIC in nanoseconds, the clock timerfd and clock_nanosleep deadlines are given on
+static inline uint64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
 }
 
-/*class Common {
+// Monotonic clock in microseconds truncated to 32 bits, wraps every ~71 minutes so compare with timestampDelta
+static inline uint32_t monotonicMicros() {
+    return uint32_t(monotonicNanos() / 1000);
+}
+
+static inline int32_t timestampDelta(const uint32_t &later, const uint32_t &earlier) {
+    return int32_t(later - earlier);
+}
+
+#if defined(QT_GUI_LIB)
+class Common {
 public:
-    static std::shared_ptr <QPixmap> buttonIcon(const int& btn, const QSize &size);
-    static std::shared_ptr <QPixmap> buttonPressedIcon(const int& btn, const QSize &size);
-    static std::shared_ptr <QPixmap> renderSvg(const std::string &fileName, const QSize &size);
-    static void loadIcons();
-
-private:
-    static QMap <int, std::shared_ptr<QPixmap>> m_iconMap;
-    static QMap <int, std::shared_ptr<QPixmap>> m_iconPressedMap;
-};*/
+    // Button and D-pad icons come from IconAtlas, anything else should go through SvgRasterizer
+    static QImage renderSvg(const QString &filename, const QSize &size);
+};
+#endif
 
 #endif // COMMON_H
@@ -0,0 +1,168 @@
+#include "iconatlas.h"
+#include "common/common.h"
+#include "common/svgrasterizer.h"
+#include <QFile>
+#include <QPainter>
+#include <QtMath>
+#include <algorithm>
+
+uint qHash(const IconAtlas::Key &key, uint seed) {
+    return qHash(key.button, seed) ^ qHash((key.state << 30) ^ (key.width << 15) ^ key.height, seed);
+}
+
+IconAtlas::IconAtlas(const int &budgetBytes, QObject *parent) : QObject(parent), m_useCounter(0) {
+    m_pageSide = int(qSqrt(budgetBytes / 4));
+}
+
+IconAtlas *IconAtlas::instance() {
+    static IconAtlas atlas(4 * 1024 * 1024);
+    return &atlas;
+}
+
+QString IconAtlas::iconFileName(const int &btn) {
+    return ":/" + QString(labelForButton(Button(btn))).toLower() + ".svg";
+}
+
+IconAtlas::Sprite IconAtlas::sprite(const int &btn, const State &state, const QSize &size) {
+    Sprite sprite;
+    if(size.isEmpty())
+        return sprite;
+
+    const Key key = {btn, state, size.width(), size.height()};
+    auto it = m_entries.find(key);
+    if(it != m_entries.end()) {
+        it->lastUse = ++m_useCounter;
+        sprite.page = m_page;
+        sprite.rect = it->rect;
+        return sprite;
+    }
+
+    request(key);
+
+    // Stand in with the closest cached size, scaling an atlas region is far cheaper than rendering the svg
+    const QHash<Key, Entry>::iterator end = m_entries.end();
+    QHash<Key, Entry>::iterator nearest = end;
+    int nearestDistance = 0;
+    for(it = m_entries.begin(); it != end; ++it) {
+        if(it.key().button != btn || it.key().state != state)
+            continue;
+        const int distance = qAbs(it.key().width - size.width()) + qAbs(it.key().height - size.height());
+        if(nearest == end || distance < nearestDistance) {
+            nearest = it;
+            nearestDistance = distance;
+        }
+    }
+    if(nearest != end) {
+        nearest->lastUse = ++m_useCounter;
+        sprite.page = m_page;
+        sprite.rect = nearest->rect;
+    }
+    return sprite;
+}
+
+void IconAtlas::request(const Key &key) {
+    if(m_pending.contains(key))
+        return;
+    const QString filename = iconFileName(key.button);
+    if(!QFile::exists(filename))
+        return;
+    m_pending.insert(key);
+
+    SvgRasterizer::instance()->rasterize(QStringList(filename), QSize(key.width, key.height), this, [this, key] (const QVector<QImage> &images) {
+        insert(key, images.first());
+    });
+}
+
+void IconAtlas::insert(const Key &key, const QImage &image) {
+    m_pending.remove(key);
+    if(image.isNull() || image.width() > m_pageSide || image.height() > m_pageSide)
+        return;
+    if(m_page.isNull()) {
+        m_page = QImage(m_pageSide, m_pageSide, QImage::Format_ARGB32_Premultiplied);
+        m_page.fill(Qt::transparent);
+    }
+
+    QRect rect;
+    if(!allocate(image.size(), rect)) {
+        // Repacking redraws the whole page, so make room for the sprite in one go and repack once.
+        // Shelves waste up to a quarter of their height, the survivors get that much slack
+        const qint64 needed = qint64(image.width()) * image.height();
+        const qint64 capacity = qint64(m_pageSide) * m_pageSide * 3 / 4;
+        qint64 used = 0;
+        for(const Entry &entry: m_entries)
+            used += qint64(entry.rect.width()) * entry.rect.height();
+        while(!m_entries.isEmpty() && used + needed > capacity)
+            used -= evictLeastRecentlyUsed();
+        repack();
+        while(!allocate(image.size(), rect)) {
+            if(m_entries.isEmpty())
+                return;
+            evictLeastRecentlyUsed();
+            repack();
+        }
+    }
+
+    QPainter painter(&m_page);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(rect.topLeft(), image);
+    painter.end();
+
+    Entry entry = {rect, ++m_useCounter};
+    m_entries.insert(key, entry);
+    emit spriteReady();
+}
+
+bool IconAtlas::allocate(const QSize &size, QRect &rect) {
+    // Shelf packing, a shelf takes sprites up to its height without wasting more than a quarter of it
+    for(Shelf &shelf: m_shelves) {
+        if(size.height() <= shelf.height && size.height() * 4 >= shelf.height * 3 && shelf.x + size.width() <= m_pageSide) {
+            rect = QRect(QPoint(shelf.x, shelf.y), size);
+            shelf.x += size.width();
+            return true;
+        }
+    }
+    const int y = m_shelves.isEmpty() ? 0 : m_shelves.last().y + m_shelves.last().height;
+    if(y + size.height() > m_pageSide || size.width() > m_pageSide)
+        return false;
+    Shelf shelf = {y, size.height(), size.width()};
+    m_shelves.push_back(shelf);
+    rect = QRect(QPoint(0, y), size);
+    return true;
+}
+
+qint64 IconAtlas::evictLeastRecentlyUsed() {
+    auto oldest = m_entries.begin();
+    for(auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if(it->lastUse < oldest->lastUse)
+            oldest = it;
+    }
+    const qint64 area = qint64(oldest->rect.width()) * oldest->rect.height();
+    m_entries.erase(oldest);
+    return area;
+}
+
+void IconAtlas::repack() {
+    // Compact the survivors into a fresh page, tallest first so shelves fill up well
+    QVector <Key> keys = m_entries.keys().toVector();
+    std::sort(keys.begin(), keys.end(), [] (const Key &a, const Key &b) {
+        return a.height > b.height;
+    });
+
+    const QImage previous = m_page;
+    m_page = QImage(m_pageSide, m_pageSide, QImage::Format_ARGB32_Premultiplied);
+    m_page.fill(Qt::transparent);
+    m_shelves.clear();
+
+    QPainter painter(&m_page);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for(const Key &key: keys) {
+        Entry &entry = m_entries[key];
+        QRect rect;
+        if(!allocate(entry.rect.size(), rect)) {
+            m_entries.remove(key);
+            continue;
+        }
+        painter.drawImage(rect.topLeft(), previous, entry.rect);
+        entry.rect = rect;
+    }
+}
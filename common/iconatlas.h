@@ -0,0 +1,76 @@
+#ifndef ICONATLAS_H
+#define ICONATLAS_H
+
+#include <QObject>
+#include <QImage>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+// Button and D-pad rasters packed into a single atlas image, keyed by (button, state, size).
+// The atlas never grows beyond its budget, least recently used sprites make room for new ones.
+// Missing sizes are rasterized on a worker thread, meanwhile the nearest cached size is returned
+class IconAtlas : public QObject {
+    Q_OBJECT
+public:
+    enum State {
+        Released,
+        Pressed,
+    };
+
+    struct Sprite {
+        QImage page;
+        QRect rect;
+        bool isNull() const { return page.isNull(); }
+    };
+
+    explicit IconAtlas(const int &budgetBytes, QObject *parent = nullptr);
+
+    static IconAtlas *instance();
+    static QString iconFileName(const int &btn);
+
+    // Draw with QPainter::drawImage(target, sprite.page, sprite.rect), the rect may be a different size than asked for
+    Sprite sprite(const int &btn, const State &state, const QSize &size);
+
+signals:
+    void spriteReady();
+
+private:
+    struct Key {
+        int button;
+        int state;
+        int width;
+        int height;
+        bool operator==(const Key &other) const {
+            return button == other.button && state == other.state && width == other.width && height == other.height;
+        }
+    };
+    friend uint qHash(const Key &key, uint seed);
+
+    struct Entry {
+        QRect rect;
+        quint64 lastUse;
+    };
+
+    struct Shelf {
+        int y;
+        int height;
+        int x;
+    };
+
+    void request(const Key &key);
+    void insert(const Key &key, const QImage &image);
+    bool allocate(const QSize &size, QRect &rect);
+    // The evicted sprite's area
+    qint64 evictLeastRecentlyUsed();
+    void repack();
+
+    int m_pageSide;
+    QImage m_page;
+    QVector <Shelf> m_shelves;
+    QHash <Key, Entry> m_entries;
+    QSet <Key> m_pending;
+    quint64 m_useCounter;
+};
+
+#endif // ICONATLAS_H
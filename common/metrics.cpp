@@ -0,0 +1,189 @@
+#include "metrics.h"
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace Metrics {
+
+Registry *Registry::instance() {
+    static Registry registry;
+    return &registry;
+}
+
+void Registry::add(const std::string &name, const std::string &help, const std::string &labels, const Counter *counter) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_back({name, help, labels, counter, nullptr});
+}
+
+void Registry::add(const std::string &name, const std::string &help, const std::string &labels, const Gauge *gauge) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_back({name, help, labels, nullptr, gauge});
+}
+
+void Registry::remove(const Counter *counter) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [counter] (const Entry &entry) {
+        return entry.counter == counter;
+    }), m_entries.end());
+}
+
+void Registry::remove(const Gauge *gauge) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [gauge] (const Entry &entry) {
+        return entry.gauge == gauge;
+    }), m_entries.end());
+}
+
+std::string Registry::exposition() const {
+    std::vector<Entry> entries;
+    std::vector<std::string> values;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entries = m_entries;
+        // Read under the lock, an owner can't remove and destroy a metric meanwhile
+        for(const Entry &entry: entries)
+            values.push_back(entry.counter ? std::to_string(entry.counter->value()) : std::to_string(entry.gauge->value()));
+    }
+    // Every sample of a metric has to follow its HELP and TYPE lines
+    std::vector<size_t> order(entries.size());
+    for(size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&entries] (const size_t &a, const size_t &b) {
+        return entries[a].name < entries[b].name;
+    });
+
+    std::string text;
+    const std::string *previous = nullptr;
+    for(const size_t &i: order) {
+        const Entry &entry = entries[i];
+        if(!previous || *previous != entry.name) {
+            text += "# HELP " + entry.name + " " + entry.help + "\n";
+            text += "# TYPE " + entry.name + (entry.counter ? " counter\n" : " gauge\n");
+            previous = &entry.name;
+        }
+        text += entry.name;
+        if(!entry.labels.empty())
+            text += "{" + entry.labels + "}";
+        text += " " + values[i] + "\n";
+    }
+    return text;
+}
+
+Server::Server(): m_listenFileDescriptor(-1), m_stopFileDescriptor(-1) {
+}
+
+Server::~Server() {
+    stop();
+}
+
+bool Server::start(const uint16_t &port, const std::string &address) {
+    if(isRunning())
+        return true;
+    struct sockaddr_in host;
+    memset(&host, 0, sizeof(host));
+    host.sin_family = AF_INET;
+    host.sin_port = htons(port);
+    if(inet_pton(AF_INET, address.c_str(), &host.sin_addr) != 1)
+        return false;
+
+    m_listenFileDescriptor = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(m_listenFileDescriptor < 0)
+        return false;
+    const int enable = 1;
+    setsockopt(m_listenFileDescriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if(bind(m_listenFileDescriptor, (const struct sockaddr*)&host, sizeof(host)) < 0 || listen(m_listenFileDescriptor, 4) < 0) {
+        close(m_listenFileDescriptor);
+        m_listenFileDescriptor = -1;
+        return false;
+    }
+    m_stopFileDescriptor = eventfd(0, EFD_CLOEXEC);
+    m_thread = std::thread(&Server::run, this);
+    return true;
+}
+
+void Server::stop() {
+    if(!isRunning())
+        return;
+    const uint64_t one = 1;
+    if(write(m_stopFileDescriptor, &one, sizeof(one)) < 0) {}
+    m_thread.join();
+    close(m_listenFileDescriptor);
+    close(m_stopFileDescriptor);
+    m_listenFileDescriptor = -1;
+    m_stopFileDescriptor = -1;
+}
+
+bool Server::isRunning() const {
+    return m_listenFileDescriptor >= 0;
+}
+
+void Server::run() {
+    struct pollfd fds[2];
+    fds[0].fd = m_listenFileDescriptor;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_stopFileDescriptor;
+    fds[1].events = POLLIN;
+    while(true) {
+        if(poll(fds, 2, -1) < 0) {
+            if(errno == EINTR)
+                continue;
+            return;
+        }
+        if(fds[1].revents)
+            return;
+        if(!(fds[0].revents & POLLIN))
+            continue;
+        const int connection = accept4(m_listenFileDescriptor, nullptr, nullptr, SOCK_CLOEXEC);
+        if(connection < 0)
+            continue;
+        serve(connection);
+        close(connection);
+    }
+}
+
+void Server::serve(const int &connection) {
+    // A scraper that stalls can't hold the thread forever
+    struct timeval timeout = {2, 0};
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters, the rest of the headers are left unread
+    char request[512];
+    size_t size = 0;
+    while(size < sizeof(request) - 1) {
+        const ssize_t received = recv(connection, request + size, sizeof(request) - 1 - size, 0);
+        if(received <= 0)
+            break;
+        size += received;
+        if(memchr(request, '\n', size))
+            break;
+    }
+    request[size] = 0;
+
+    std::string status = "200 OK", body;
+    if(strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0) {
+        body = Registry::instance()->exposition();
+    } else {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+    const std::string response = "HTTP/1.0 " + status + "\r\n"
+                                 "Content-Type: text/plain; version=0.0.4\r\n"
+                                 "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                 "Connection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while(sent < response.size()) {
+        const ssize_t written = send(connection, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if(written <= 0)
+            break;
+        sent += written;
+    }
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Metrics {
+
+// Monotonic counter with a single writing thread. Adding is a relaxed load and store on the writer's
+// own cache line, no locked instruction, so the input path never waits on the exposition thread
+class Counter {
+public:
+    Counter(): m_value(0) {}
+    Counter(const Counter &) = delete;
+    Counter &operator=(const Counter &) = delete;
+
+    inline void add(const uint64_t &amount = 1) {
+        m_value.store(m_value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    inline uint64_t value() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<uint64_t> m_value;
+};
+
+// Value that goes up and down, same single writer rule as the counter
+class Gauge {
+public:
+    Gauge(): m_value(0) {}
+    Gauge(const Gauge &) = delete;
+    Gauge &operator=(const Gauge &) = delete;
+
+    inline void set(const int64_t &value) {
+        m_value.store(value, std::memory_order_relaxed);
+    }
+
+    inline int64_t value() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> m_value;
+};
+
+// Counters and gauges owned by long-lived objects, registered at construction and removed before destruction.
+// The lock only guards the list, counting never touches it
+class Registry {
+public:
+    static Registry *instance();
+
+    // Labels in Prometheus syntax without the braces, e.g. transport="udp",role="slave"
+    void add(const std::string &name, const std::string &help, const std::string &labels, const Counter *counter);
+    void add(const std::string &name, const std::string &help, const std::string &labels, const Gauge *gauge);
+    void remove(const Counter *counter);
+    void remove(const Gauge *gauge);
+    // Text exposition format 0.0.4
+    std::string exposition() const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        std::string labels;
+        // One of the two is set
+        const Counter *counter;
+        const Gauge *gauge;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+};
+
+// Serves the registry over HTTP on its own thread, GET /metrics only
+class Server {
+public:
+    Server();
+    ~Server();
+
+    // Local only unless another address is given
+    bool start(const uint16_t &port, const std::string &address = "127.0.0.1");
+    void stop();
+    bool isRunning() const;
+
+private:
+    void run();
+    void serve(const int &connection);
+
+    int m_listenFileDescriptor;
+    int m_stopFileDescriptor;
+    std::thread m_thread;
+};
+
+}
+
+#endif // METRICS_H
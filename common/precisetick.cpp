@@ -0,0 +1,117 @@
+#include "precisetick.h"
+#include "common/common.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+static void toTimespec(const uint64_t &ns, struct timespec &ts) {
+    ts.tv_sec = ns / 1000000000ull;
+    ts.tv_nsec = ns % 1000000000ull;
+}
+
+PreciseTick::PreciseTick(): m_periodus(1000), m_spinus(0), m_active(false), m_deadline(0) {
+    m_fileDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(m_fileDescriptor < 0) {
+        printf("error: tick timerfd");
+    }
+    resetStats();
+}
+
+PreciseTick::~PreciseTick() {
+    if(m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+}
+
+void PreciseTick::setPeriod(const uint32_t &us) {
+    m_periodus = us ? us : 1;
+    if(m_active)
+        start();
+}
+
+uint32_t PreciseTick::period() const {
+    return m_periodus;
+}
+
+void PreciseTick::setSpin(const uint32_t &us) {
+    m_spinus = us < m_periodus ? us : m_periodus - 1;
+    if(m_active)
+        start();
+}
+
+uint32_t PreciseTick::spin() const {
+    return m_spinus;
+}
+
+void PreciseTick::setCallback(const std::function<void()> &callback) {
+    m_callback = callback;
+}
+
+void PreciseTick::start() {
+    if(m_fileDescriptor < 0)
+        return;
+    const uint64_t period = uint64_t(m_periodus) * 1000;
+    m_deadline = monotonicNanos() + period;
+
+    // Absolute first expiry plus the kernel's interval, no re-arming per tick
+    struct itimerspec spec;
+    toTimespec(m_deadline - uint64_t(m_spinus) * 1000, spec.it_value);
+    toTimespec(period, spec.it_interval);
+    timerfd_settime(m_fileDescriptor, TFD_TIMER_ABSTIME, &spec, nullptr);
+    m_active = true;
+}
+
+void PreciseTick::stop() {
+    if(m_fileDescriptor < 0)
+        return;
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    timerfd_settime(m_fileDescriptor, 0, &spec, nullptr);
+    m_active = false;
+}
+
+bool PreciseTick::isActive() const {
+    return m_active;
+}
+
+int PreciseTick::fileDescriptor() const {
+    return m_fileDescriptor;
+}
+
+void PreciseTick::onReadable() {
+    uint64_t expirations = 0;
+    if(read(m_fileDescriptor, &expirations, sizeof(expirations)) != sizeof(expirations) || expirations == 0 || !m_active)
+        return;
+
+    // Catch up to the latest expiry, the skipped ones are counted rather than replayed in a burst
+    const uint64_t period = uint64_t(m_periodus) * 1000;
+    const uint64_t deadline = m_deadline + (expirations - 1) * period;
+    m_deadline = deadline + period;
+    m_stats.missed += expirations - 1;
+
+    uint64_t now = monotonicNanos();
+    while(m_spinus && now < deadline)
+        now = monotonicNanos();
+
+    const int64_t error = int64_t(now - deadline);
+    ++m_stats.ticks;
+    m_stats.lastErrorns = error;
+    if(error > m_stats.maxErrorns)
+        m_stats.maxErrorns = error;
+    m_totalErrorns += error;
+
+    if(m_callback)
+        m_callback();
+}
+
+PreciseTick::Stats PreciseTick::stats() const {
+    Stats stats = m_stats;
+    stats.meanErrorns = stats.ticks ? m_totalErrorns / int64_t(stats.ticks) : 0;
+    return stats;
+}
+
+void PreciseTick::resetStats() {
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_totalErrorns = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef PRECISETICK_H
+#define PRECISETICK_H
+
+#include <cstdint>
+#include <functional>
+
+// Periodic tick on a CLOCK_MONOTONIC timerfd, for fixed-rate work like the driver's sync reports.
+// The kernel keeps the period drift free. With a spin set the timerfd fires that much early and the
+// rest is busy-waited, trading a little CPU for sub-slack wakeups. The host loop polls fileDescriptor()
+class PreciseTick {
+public:
+    struct Stats {
+        uint64_t ticks;
+        // Periods that passed without a callback because the loop woke too late
+        uint64_t missed;
+        int64_t lastErrorns;
+        int64_t maxErrorns;
+        int64_t meanErrorns;
+    };
+
+    PreciseTick();
+    ~PreciseTick();
+
+    void setPeriod(const uint32_t &us);
+    uint32_t period() const;
+    // How long before the deadline to wake and spin, 0 disables spinning
+    void setSpin(const uint32_t &us);
+    uint32_t spin() const;
+    void setCallback(const std::function<void()> &callback);
+
+    void start();
+    void stop();
+    bool isActive() const;
+
+    int fileDescriptor() const;
+    void onReadable();
+
+    // Wakeup error is how late the callback ran against its deadline
+    Stats stats() const;
+    void resetStats();
+
+private:
+    int m_fileDescriptor;
+    uint32_t m_periodus;
+    uint32_t m_spinus;
+    bool m_active;
+    // Deadline of the next expiry, spin excluded
+    uint64_t m_deadline;
+    std::function<void()> m_callback;
+    Stats m_stats;
+    int64_t m_totalErrorns;
+};
+
+#endif // PRECISETICK_H
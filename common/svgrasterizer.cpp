@@ -0,0 +1,47 @@
+#include "svgrasterizer.h"
+#include "common/common.h"
+#include <QAtomicInt>
+#include <QtConcurrent>
+#include <QSharedPointer>
+
+SvgRasterizer::SvgRasterizer() {
+    // Leave a core for the GUI and network threads
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+SvgRasterizer *SvgRasterizer::instance() {
+    static SvgRasterizer rasterizer;
+    return &rasterizer;
+}
+
+void SvgRasterizer::rasterize(const QStringList &filenames, const QSize &size, QObject *receiver, const Callback &done) {
+    if(filenames.isEmpty())
+        return;
+
+    struct Batch {
+        QVector <QImage> images;
+        QAtomicInt remaining;
+        QPointer <QObject> receiver;
+        Callback done;
+    };
+    QSharedPointer <Batch> batch(new Batch);
+    batch->images.resize(filenames.size());
+    batch->remaining = filenames.size();
+    batch->receiver = receiver;
+    batch->done = done;
+
+    for(int i = 0; i < filenames.size(); ++i) {
+        const QString filename = filenames[i];
+        QImage *image = batch->images.data() + i; // Taken here so the workers never touch the vector itself
+        QtConcurrent::run(&m_pool, [this, batch, image, filename, size] () {
+            *image = Common::renderSvg(filename, size);
+            if(!batch->remaining.deref()) {
+                // Last one publishes the whole batch, the receiver check happens on the GUI thread
+                QMetaObject::invokeMethod(this, [batch] () {
+                    if(batch->receiver)
+                        batch->done(batch->images);
+                }, Qt::QueuedConnection);
+            }
+        });
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef SVGRASTERIZER_H
+#define SVGRASTERIZER_H
+
+#include <QObject>
+#include <QImage>
+#include <QPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+
+// Worker pool rasterizing svg files off the GUI thread. A request's images are delivered
+// together in a single callback on the GUI thread, so a widget never shows half a frame set.
+// Callbacks of receivers destroyed in the meantime are dropped
+class SvgRasterizer : public QObject {
+    Q_OBJECT
+public:
+    typedef std::function<void(const QVector<QImage> &)> Callback;
+
+    static SvgRasterizer *instance();
+
+    void rasterize(const QStringList &filenames, const QSize &size, QObject *receiver, const Callback &done);
+
+private:
+    SvgRasterizer();
+
+    QThreadPool m_pool;
+};
+
+#endif // SVGRASTERIZER_H
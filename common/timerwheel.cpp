@@ -0,0 +1,248 @@
+#include "timerwheel.h"
+#include "common/common.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+TimerWheel::Timer::Timer(): m_prev(nullptr), m_next(nullptr), m_wheel(nullptr), m_expiry(0), m_slot(Unlinked), m_interval(0), m_singleShot(false) {
+}
+
+TimerWheel::Timer::~Timer() {
+    stop();
+}
+
+void TimerWheel::Timer::setCallback(const std::function<void()> &callback) {
+    m_callback = callback;
+}
+
+void TimerWheel::Timer::setInterval(const uint32_t &ms) {
+    m_interval = ms;
+}
+
+uint32_t TimerWheel::Timer::interval() const {
+    return m_interval;
+}
+
+void TimerWheel::Timer::setSingleShot(const bool &singleShot) {
+    m_singleShot = singleShot;
+}
+
+bool TimerWheel::Timer::isSingleShot() const {
+    return m_singleShot;
+}
+
+void TimerWheel::Timer::start() {
+    stop();
+    m_wheel = TimerWheel::current();
+    m_expiry = m_wheel->now() + m_interval;
+    m_wheel->insert(this);
+}
+
+void TimerWheel::Timer::start(const uint32_t &ms) {
+    m_interval = ms;
+    start();
+}
+
+void TimerWheel::Timer::stop() {
+    unlink();
+}
+
+bool TimerWheel::Timer::isActive() const {
+    return m_slot != Unlinked;
+}
+
+void TimerWheel::Timer::unlink() {
+    if(m_slot == Unlinked)
+        return;
+    m_prev->m_next = m_next;
+    m_next->m_prev = m_prev;
+    if(m_slot >= 0) {
+        const int level = m_slot / Slots;
+        const int slot = m_slot % Slots;
+        const Timer &head = m_wheel->m_slots[level][slot];
+        if(head.m_next == &head)
+            m_wheel->m_occupied[level] &= ~(uint64_t(1) << slot);
+    }
+    m_prev = m_next = nullptr;
+    m_slot = Unlinked;
+    --m_wheel->m_count;
+}
+
+TimerWheel::TimerWheel(): m_originNanos(monotonicNanos()), m_current(0), m_count(0), m_armedTick(0) {
+    m_fileDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(m_fileDescriptor < 0) {
+        printf("error: timer wheel timerfd");
+    }
+    for(int level = 0; level < Levels; ++level) {
+        m_occupied[level] = 0;
+        for(int slot = 0; slot < Slots; ++slot)
+            m_slots[level][slot].m_prev = m_slots[level][slot].m_next = &m_slots[level][slot];
+    }
+}
+
+TimerWheel::~TimerWheel() {
+    // Leave outliving timers inactive rather than pointing into a dead wheel
+    for(int level = 0; level < Levels; ++level) {
+        for(int slot = 0; slot < Slots; ++slot) {
+            Timer &head = m_slots[level][slot];
+            while(head.m_next != &head)
+                head.m_next->unlink();
+        }
+    }
+    if(m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+}
+
+TimerWheel *TimerWheel::current() {
+    static thread_local TimerWheel wheel;
+    return &wheel;
+}
+
+int TimerWheel::fileDescriptor() const {
+    return m_fileDescriptor;
+}
+
+uint64_t TimerWheel::now() const {
+    return (monotonicNanos() - m_originNanos) / 1000000;
+}
+
+void TimerWheel::onReadable() {
+    uint64_t expirations;
+    while(read(m_fileDescriptor, &expirations, sizeof(expirations)) > 0) {}
+    advance(now());
+    m_armedTick = 0;
+    arm();
+}
+
+void TimerWheel::insert(Timer *timer) {
+    ++m_count;
+    place(timer, m_current + 1);
+    arm();
+}
+
+void TimerWheel::place(Timer *timer, const uint64_t &earliest) {
+    // Beyond the wheel's span the timer is parked at the far end and re-queued from there
+    uint64_t tick = timer->m_expiry < earliest ? earliest : timer->m_expiry;
+    if(tick > (m_current | MaxSpan))
+        tick = m_current | MaxSpan;
+
+    // The highest 6 bit group where tick and now differ picks the level, so the slot is always ahead of now
+    const uint64_t diff = tick ^ m_current;
+    const int level = diff ? (63 - __builtin_clzll(diff)) / LevelBits : 0;
+    const int slot = (tick >> (level * LevelBits)) & (Slots - 1);
+
+    Timer &head = m_slots[level][slot];
+    timer->m_prev = head.m_prev;
+    timer->m_next = &head;
+    head.m_prev->m_next = timer;
+    head.m_prev = timer;
+    timer->m_slot = level * Slots + slot;
+    m_occupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::advance(const uint64_t &target) {
+    // Jump straight between ticks that have work instead of stepping through every millisecond
+    for(uint64_t tick = nextTick(); tick && tick <= target; tick = nextTick()) {
+        m_current = tick;
+        for(int level = Levels - 1; level > 0; --level) {
+            if((tick & ((uint64_t(1) << (level * LevelBits)) - 1)) == 0)
+                cascade(level, (tick >> (level * LevelBits)) & (Slots - 1));
+        }
+        fire(tick & (Slots - 1));
+    }
+    if(target > m_current)
+        m_current = target;
+}
+
+void TimerWheel::cascade(const int &level, const int &slot) {
+    Timer &head = m_slots[level][slot];
+    m_occupied[level] &= ~(uint64_t(1) << slot);
+    Timer *timer = head.m_next;
+    head.m_prev = head.m_next = &head;
+    while(timer != &head) {
+        Timer *next = timer->m_next;
+        // Due right now lands in the level 0 slot fired next
+        place(timer, m_current);
+        timer = next;
+    }
+}
+
+void TimerWheel::fire(const int &slot) {
+    Timer &head = m_slots[0][slot];
+    if(head.m_next == &head)
+        return;
+
+    // Detach the slot first, callbacks may start and stop timers including these
+    Timer pending;
+    pending.m_prev = head.m_prev;
+    pending.m_next = head.m_next;
+    pending.m_prev->m_next = &pending;
+    pending.m_next->m_prev = &pending;
+    head.m_prev = head.m_next = &head;
+    m_occupied[0] &= ~(uint64_t(1) << slot);
+    for(Timer *timer = pending.m_next; timer != &pending; timer = timer->m_next)
+        timer->m_slot = Pending;
+
+    while(pending.m_next != &pending) {
+        Timer *timer = pending.m_next;
+        timer->unlink();
+        ++m_count;
+        if(timer->m_expiry > m_current) {
+            // Parked at the far end of the wheel, not due yet
+            place(timer, m_current + 1);
+            continue;
+        }
+        if(timer->m_singleShot) {
+            --m_count;
+        } else {
+            // Next period from the deadline, not from now, so periodic timers don't drift
+            const uint64_t period = timer->m_interval ? timer->m_interval : 1;
+            timer->m_expiry += period;
+            if(timer->m_expiry <= m_current)
+                timer->m_expiry = m_current + period;
+            place(timer, m_current + 1);
+        }
+        // The callback may destroy the timer, nothing touches it afterwards
+        const std::function<void()> callback = timer->m_callback;
+        if(callback)
+            callback();
+    }
+}
+
+uint64_t TimerWheel::nextTick() const {
+    uint64_t next = 0;
+    for(int level = 0; level < Levels; ++level) {
+        if(!m_occupied[level])
+            continue;
+        const int shift = level * LevelBits;
+        const int index = (m_current >> shift) & (Slots - 1);
+        const uint64_t ahead = m_occupied[level] & ~((uint64_t(2) << index) - 1);
+        if(!ahead)
+            continue;
+        const uint64_t base = (m_current >> (shift + LevelBits)) << (shift + LevelBits);
+        const uint64_t tick = base | (uint64_t(__builtin_ctzll(ahead)) << shift);
+        if(!next || tick < next)
+            next = tick;
+    }
+    return next;
+}
+
+void TimerWheel::arm() {
+    if(m_fileDescriptor < 0)
+        return;
+    const uint64_t tick = nextTick();
+    if(tick == m_armedTick)
+        return;
+    m_armedTick = tick;
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if(tick) {
+        const uint64_t deadline = m_originNanos + tick * 1000000;
+        spec.it_value.tv_sec = deadline / 1000000000ull;
+        spec.it_value.tv_nsec = deadline % 1000000000ull;
+    }
+    timerfd_settime(m_fileDescriptor, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
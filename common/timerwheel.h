@@ -0,0 +1,88 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstdint>
+#include <functional>
+
+// Hierarchical timer wheel with 1 ms ticks, one per thread, driven by a single timerfd.
+// Four levels of 64 slots cover about 4.6 hours, longer timeouts are re-queued when they come up.
+// Arming and cancelling a timer is O(1) unlinking of an intrusive list node, so the cost stays
+// flat however many sessions own timers. The host loop polls fileDescriptor() and calls onReadable()
+class TimerWheel {
+public:
+    // Same shape as QTimer, the callback replaces the timeout signal
+    class Timer {
+    public:
+        Timer();
+        ~Timer();
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+        void setCallback(const std::function<void()> &callback);
+        void setInterval(const uint32_t &ms);
+        uint32_t interval() const;
+        void setSingleShot(const bool &singleShot);
+        bool isSingleShot() const;
+
+        // Arms on the calling thread's wheel, restarting if already active
+        void start();
+        void start(const uint32_t &ms);
+        void stop();
+        bool isActive() const;
+
+    private:
+        friend class TimerWheel;
+        void unlink();
+
+        Timer *m_prev;
+        Timer *m_next;
+        TimerWheel *m_wheel;
+        uint64_t m_expiry;
+        // level * Slots + slot while queued, Unlinked or Pending otherwise
+        int m_slot;
+        uint32_t m_interval;
+        bool m_singleShot;
+        std::function<void()> m_callback;
+    };
+
+    TimerWheel();
+    ~TimerWheel();
+
+    // The calling thread's wheel, created on first use
+    static TimerWheel *current();
+
+    int fileDescriptor() const;
+    // Fires everything due and re-arms the timerfd for the next expiry
+    void onReadable();
+    // Milliseconds on the wheel's clock
+    uint64_t now() const;
+
+private:
+    static const int LevelBits = 6;
+    static const int Levels = 4;
+    static const int Slots = 1 << LevelBits;
+    static const uint64_t MaxSpan = (uint64_t(1) << (LevelBits * Levels)) - 1;
+    static const int Unlinked = -1;
+    static const int Pending = -2;
+
+    void insert(Timer *timer);
+    void place(Timer *timer, const uint64_t &earliest);
+    void advance(const uint64_t &target);
+    void cascade(const int &level, const int &slot);
+    void fire(const int &slot);
+    // Next tick with anything to cascade or fire, 0 when the wheel is empty
+    uint64_t nextTick() const;
+    void arm();
+
+    int m_fileDescriptor;
+    // Clock origin, ticks count from here
+    uint64_t m_originNanos;
+    uint64_t m_current;
+    int m_count;
+    // Sentinel heads, a slot is empty when the head points at itself
+    Timer m_slots[Levels][Slots];
+    uint64_t m_occupied[Levels];
+    uint64_t m_armedTick;
+};
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,127 @@
+#include "trace.h"
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace Trace {
+
+const uint32_t Ring::Capacity;
+
+// Rings outlive their threads so a dump still shows threads that have finished
+struct Registry {
+    std::mutex mutex;
+    std::vector<Ring*> rings;
+};
+
+static Registry &registry() {
+    static Registry *registry = new Registry;
+    return *registry;
+}
+
+static void escape(std::string &json, const std::string &text) {
+    for(const char &c: text) {
+        if(c == '"' || c == '\\')
+            json += '\\';
+        json += c;
+    }
+}
+
+// Chrome wants microseconds, the fraction keeps the nanoseconds
+static void appendMicros(std::string &json, const uint64_t &ns) {
+    const uint64_t fraction = ns % 1000;
+    json += std::to_string(ns / 1000);
+    json += fraction < 10 ? ".00" : fraction < 100 ? ".0" : ".";
+    json += std::to_string(fraction);
+}
+
+Ring::Ring(const uint32_t &threadId): m_threadId(threadId), m_written(0) {
+    for(Event &event: m_events)
+        event.sequence.store(0, std::memory_order_relaxed);
+}
+
+void Ring::record(const char *name, const uint64_t &beginns, const uint64_t &endns) {
+    const uint64_t index = m_written.load(std::memory_order_relaxed);
+    Event &event = m_events[index % Capacity];
+    // Seqlock on the slot, a dump that catches it mid-write sees the sequence change and skips it
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.beginns.store(beginns, std::memory_order_relaxed);
+    event.endns.store(endns, std::memory_order_relaxed);
+    event.sequence.store(index + 1, std::memory_order_release);
+    m_written.store(index + 1, std::memory_order_release);
+}
+
+void Ring::append(std::string &json, const uint32_t &processId) const {
+    const uint64_t written = m_written.load(std::memory_order_acquire);
+    for(uint64_t index = written > Capacity ? written - Capacity : 0; index < written; ++index) {
+        const Event &event = m_events[index % Capacity];
+        const uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+        const char *name = event.name.load(std::memory_order_relaxed);
+        const uint64_t beginns = event.beginns.load(std::memory_order_relaxed);
+        const uint64_t endns = event.endns.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(sequence != index + 1 || event.sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+
+        json += "{\"name\":\"";
+        escape(json, name);
+        json += "\",\"pid\":" + std::to_string(processId) + ",\"tid\":" + std::to_string(m_threadId) + ",\"ts\":";
+        appendMicros(json, beginns);
+        if(endns == beginns) {
+            json += ",\"ph\":\"i\",\"s\":\"t\"},\n";
+        } else {
+            json += ",\"ph\":\"X\",\"dur\":";
+            appendMicros(json, endns - beginns);
+            json += "},\n";
+        }
+    }
+}
+
+Ring *current() {
+    thread_local Ring *ring = nullptr;
+    if(!ring) {
+        ring = new Ring(syscall(SYS_gettid));
+        Registry &entries = registry();
+        std::lock_guard<std::mutex> lock(entries.mutex);
+        entries.rings.push_back(ring);
+    }
+    return ring;
+}
+
+void setThreadName(const std::string &name) {
+    // No ring for a name alone when nothing will be recorded
+    if(!isEnabled())
+        return;
+    Ring *ring = current();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    ring->m_name = name;
+}
+
+bool dump(const std::string &path) {
+    const uint32_t processId = getpid();
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    {
+        Registry &entries = registry();
+        std::lock_guard<std::mutex> lock(entries.mutex);
+        for(const Ring *ring: entries.rings) {
+            if(!ring->m_name.empty()) {
+                json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(processId) + ",\"tid\":" +
+                        std::to_string(ring->m_threadId) + ",\"args\":{\"name\":\"";
+                escape(json, ring->m_name);
+                json += "\"}},\n";
+            }
+            ring->append(json, processId);
+        }
+    }
+    // Every entry ends in a comma, the process name closes the list without one
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(processId) + ",\"args\":{\"name\":\"openrudder\"}}\n]}\n";
+
+    std::ofstream file(path, std::ios::trunc);
+    file << json;
+    return bool(file);
+}
+
+}
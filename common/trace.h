@@ -0,0 +1,86 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "common/common.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped trace points for a timeline of the pipeline, dumped as Chrome trace JSON that chrome://tracing and
+// Perfetto open. Without OPENRUDDER_TRACE the macros expand to nothing, so trace points cost nothing in
+// normal builds. With it, each thread records into its own ring: a thread local lookup, two clock reads and
+// a few relaxed stores per scope, no lock. Names must be string literals, only the pointer is kept
+namespace Trace {
+
+struct Event {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> beginns;
+    // Equal to beginns for instants
+    std::atomic<uint64_t> endns;
+    // Index + 1 once the event is complete, 0 while it's being written, lets a dump skip torn slots
+    std::atomic<uint64_t> sequence;
+};
+
+// One writer, the owning thread. Old events are overwritten once the ring is full
+class Ring {
+public:
+    static const uint32_t Capacity = 1 << 14;
+
+    Ring(const uint32_t &threadId);
+
+    void record(const char *name, const uint64_t &beginns, const uint64_t &endns);
+    // Complete events, oldest first, in Chrome's JSON form
+    void append(std::string &json, const uint32_t &processId) const;
+
+    const uint32_t m_threadId;
+    // Guarded by the registry lock, not by the ring
+    std::string m_name;
+
+private:
+    std::atomic<uint64_t> m_written;
+    Event m_events[Capacity];
+};
+
+constexpr bool isEnabled() {
+#if defined(OPENRUDDER_TRACE)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// The calling thread's ring, created and registered on first use and kept until exit
+Ring *current();
+// Shown as the thread's name in the viewer, call before recording
+void setThreadName(const std::string &name);
+// Every thread's events so far, written to path. Safe to call from any thread while the others record
+bool dump(const std::string &path);
+
+class Scope {
+public:
+    inline Scope(const char *name): m_name(name), m_beginns(monotonicNanos()) {}
+    inline ~Scope() {
+        current()->record(m_name, m_beginns, monotonicNanos());
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_name;
+    const uint64_t m_beginns;
+};
+
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#if defined(OPENRUDDER_TRACE)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_INSTANT(name) do { const uint64_t traceNow = monotonicNanos(); Trace::current()->record(name, traceNow, traceNow); } while(0)
+#else
+#define TRACE_SCOPE(name) do {} while(0)
+#define TRACE_INSTANT(name) do {} while(0)
+#endif
+
+#endif // TRACE_H
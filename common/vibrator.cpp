@@ -0,0 +1,58 @@
+#include "vibrator.h"
+#include <QtGlobal>
+#if defined(Q_OS_ANDROID)
+#include <QtAndroid>
+#include <QAndroidJniObject>
+#include <QAndroidJniEnvironment>
+#endif
+
+// Phones have a single motor, "until stopped" is approximated by a long one shot
+static const int64_t UntilStoppedms = 10000;
+
+#if defined(Q_OS_ANDROID)
+static QAndroidJniObject &vibratorService() {
+    // Resolved once, the JNI lookups are too slow for every rumble command
+    static QAndroidJniObject vibrator = [] () {
+        const QAndroidJniObject name = QAndroidJniObject::getStaticObjectField<jstring>("android/content/Context", "VIBRATOR_SERVICE");
+        return QtAndroid::androidActivity().callObjectMethod("getSystemService", "(Ljava/lang/String;)Ljava/lang/Object;", name.object<jstring>());
+    }();
+    return vibrator;
+}
+#endif
+
+Vibrator::Vibrator() {
+}
+
+Vibrator *Vibrator::instance() {
+    static Vibrator vibrator;
+    return &vibrator;
+}
+
+void Vibrator::vibrate(const uint16_t &strong, const uint16_t &weak, const uint16_t &durationms) {
+    if(strong == 0 && weak == 0) {
+        stop();
+        return;
+    }
+#if defined(Q_OS_ANDROID)
+    QAndroidJniObject &vibrator = vibratorService();
+    if(!vibrator.isValid())
+        return;
+    // The strong motor dominates, weak alone still needs to be felt
+    const uint32_t magnitude = strong > weak ? strong : uint32_t(weak) * 2 / 3;
+    const jint amplitude = 1 + magnitude * 254 / 0xffff;
+    const jlong duration = durationms ? durationms : UntilStoppedms;
+    const QAndroidJniObject effect = QAndroidJniObject::callStaticObjectMethod("android/os/VibrationEffect", "createOneShot", "(JI)Landroid/os/VibrationEffect;", duration, amplitude);
+    vibrator.callMethod<void>("vibrate", "(Landroid/os/VibrationEffect;)V", effect.object());
+    QAndroidJniEnvironment env;
+    if(env->ExceptionCheck())
+        env->ExceptionClear();
+#endif
+}
+
+void Vibrator::stop() {
+#if defined(Q_OS_ANDROID)
+    QAndroidJniObject &vibrator = vibratorService();
+    if(vibrator.isValid())
+        vibrator.callMethod<void>("cancel");
+#endif
+}
@@ -0,0 +1,19 @@
+#ifndef VIBRATOR_H
+#define VIBRATOR_H
+
+#include <cstdint>
+
+// Plays rumble on the device's vibration motor, does nothing on platforms without one
+class Vibrator {
+public:
+    static Vibrator *instance();
+
+    // Magnitudes as in RumbleEvent, a zero duration runs until stop() or the next vibrate()
+    void vibrate(const uint16_t &strong, const uint16_t &weak, const uint16_t &durationms);
+    void stop();
+
+private:
+    Vibrator();
+};
+
+#endif // VIBRATOR_H
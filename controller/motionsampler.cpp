@@ -0,0 +1,100 @@
+#include "motionsampler.h"
+#include "common/common.h"
+#include <QGyroscope>
+#include <QAccelerometer>
+
+static const float StandardGravity = 9.80665f;
+
+MotionSampler::MotionSampler(QObject *parent) : QObject(parent), m_rate(500), m_samplesPerPacket(0), m_clockSynced(false), m_clockOffset(0) {
+    m_gyroscope = new QGyroscope(this);
+    m_accelerometer = new QAccelerometer(this);
+    // Gravity included, games expect the raw accelerometer like a real pad reports it
+    m_accelerometer->setAccelerationMode(QAccelerometer::Combined);
+    // Accel readings are only picked up when the gyro fires
+    connect(m_gyroscope, &QGyroscope::readingChanged, this, &MotionSampler::onGyroscopeReading);
+}
+
+MotionSampler::~MotionSampler() {
+}
+
+int MotionSampler::rate() const {
+    return m_rate;
+}
+
+void MotionSampler::setRate(const int &rate) {
+    m_rate = rate;
+    if(isActive()) {
+        stop();
+        start();
+    }
+}
+
+int MotionSampler::samplesPerPacket() const {
+    return m_samplesPerPacket;
+}
+
+void MotionSampler::setSamplesPerPacket(const int &samples) {
+    m_samplesPerPacket = qBound(0, samples, MotionPacket::MaxSamples);
+}
+
+bool MotionSampler::isActive() const {
+    return m_gyroscope->isActive();
+}
+
+void MotionSampler::start() {
+    m_gyroscope->setDataRate(m_rate);
+    m_accelerometer->setDataRate(m_rate);
+    m_clockSynced = false;
+    m_packet.clear();
+    m_accelerometer->start();
+    m_gyroscope->start();
+}
+
+void MotionSampler::stop() {
+    m_gyroscope->stop();
+    m_accelerometer->stop();
+    flush();
+}
+
+void MotionSampler::onGyroscopeReading() {
+    const QGyroscopeReading *gyro = m_gyroscope->reading();
+    const QAccelerometerReading *accel = m_accelerometer->reading();
+    if(!gyro)
+        return;
+
+    const uint32_t sensorTime = uint32_t(gyro->timestamp());
+    if(!m_clockSynced) {
+        m_clockOffset = monotonicMicros() - sensorTime;
+        m_clockSynced = true;
+    }
+
+    MotionPacket::Sample sample;
+    sample.timestamp = sensorTime + m_clockOffset;
+    sample.gyro[0] = MotionPacket::quantize(gyro->x(), MotionPacket::GyroPerDps);
+    sample.gyro[1] = MotionPacket::quantize(gyro->y(), MotionPacket::GyroPerDps);
+    sample.gyro[2] = MotionPacket::quantize(gyro->z(), MotionPacket::GyroPerDps);
+    for(int axis = 0; axis < 3; ++axis)
+        sample.accel[axis] = 0;
+    if(accel) {
+        sample.accel[0] = MotionPacket::quantize(accel->x() / StandardGravity, MotionPacket::AccelPerG);
+        sample.accel[1] = MotionPacket::quantize(accel->y() / StandardGravity, MotionPacket::AccelPerG);
+        sample.accel[2] = MotionPacket::quantize(accel->z() / StandardGravity, MotionPacket::AccelPerG);
+    }
+
+    if(!m_packet.append(sample)) {
+        // Full, or too long since the last sample for the 16 bit delta
+        flush();
+        m_packet.append(sample);
+    }
+
+    const int samplesPerPacket = m_samplesPerPacket ? m_samplesPerPacket : qBound(1, m_rate / 250, MotionPacket::MaxSamples);
+    if(m_packet.m_count >= samplesPerPacket)
+        flush();
+}
+
+void MotionSampler::flush() {
+    if(m_packet.isEmpty())
+        return;
+    emit packetReady(m_packet.data());
+    m_packet.clear();
+}
@@ -0,0 +1,51 @@
+#ifndef MOTIONSAMPLER_H
+#define MOTIONSAMPLER_H
+
+#include "event/motionpacket.h"
+#include <QObject>
+#include <vector>
+
+class QGyroscope;
+class QAccelerometer;
+
+// Samples the phone's gyroscope at a high rate, pairs each reading with the latest accelerometer
+// reading and hands them out a few per packet to keep the per-sample overhead small
+class MotionSampler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MotionSampler(QObject *parent = nullptr);
+    ~MotionSampler();
+
+    // Requested sensor rate in Hz, the hardware may deliver less
+    int rate() const;
+    void setRate(const int &rate);
+
+    // How many samples wait for a packet, 0 picks about 4 ms worth for the rate
+    int samplesPerPacket() const;
+    void setSamplesPerPacket(const int &samples);
+
+    bool isActive() const;
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void packetReady(std::vector<uint8_t> data);
+
+private:
+    void onGyroscopeReading();
+    void flush();
+
+    QGyroscope *m_gyroscope;
+    QAccelerometer *m_accelerometer;
+    int m_rate;
+    int m_samplesPerPacket;
+    // Sensor timestamps have their own epoch, this maps them onto monotonicMicros()
+    bool m_clockSynced;
+    uint32_t m_clockOffset;
+    MotionPacket m_packet;
+};
+
+#endif // MOTIONSAMPLER_H
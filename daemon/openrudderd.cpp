@@ -0,0 +1,252 @@
+// Headless driver: UdpTransceiver, or SharedMemoryTransceiver for local producers, feeding
+// LinuxGamepadDriver from a single epoll loop. No Qt or wx, no display needed, the GUI in main.cpp is an optional front end
+#include "transceiver/udptransceiver.h"
+#include "transceiver/sharedmemorytransceiver.h"
+#include "driver/linuxgamepaddriver.h"
+#include "common/timerwheel.h"
+#include "common/metrics.h"
+#include "common/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+
+static void usage(const char *name) {
+    printf("Usage: %s [options]\n"
+           "  --interface <address>  Address to bind, all interfaces by default\n"
+           "  --port <port>          UDP port, 45800 by default\n"
+           "  --local                Take input from same-host producers through shared memory\n"
+           "  --socket <path>        Socket the local producers connect to, implies --local\n"
+           "  --redundancy <copies>  Extra copies the master should send of acknowledged input\n"
+           "  --jitter-buffer        Smooth out bursty stick updates\n"
+           "  --predict              Extrapolate sticks through packet gaps\n"
+           "  --sync-spin <us>       Spin this long before each sync tick\n"
+           "  --profile <file>       Remap profile to load\n"
+           "  --record <file>        Record the session for inputreplay\n"
+           "  --metrics-port <port>  Serve Prometheus counters on 127.0.0.1\n"
+           "  --trace <file>         Write a Chrome trace on SIGUSR1 and at exit, needs a TRACE=1 build\n"
+           "  --verbose              Print connection changes and errors\n", name);
+}
+
+static bool loadProfile(LinuxGamepadDriver &driver, const std::string &path) {
+    std::ifstream file(path);
+    if(!file) {
+        fprintf(stderr, "Can't open profile %s\n", path.c_str());
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    std::string error;
+    if(!driver.setRemapProfile(text.str(), error)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::string interfaceAddress, profilePath, recordPath, tracePath, socketPath = SharedMemoryTransceiver::defaultPath();
+    uint16_t port = 45800, metricsPort = 0;
+    uint32_t syncSpin = 0, redundancy = 0;
+    bool local = false, jitterBuffer = false, predict = false, verbose = false;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if(arg == "--interface" && hasValue) {
+            interfaceAddress = argv[++i];
+        } else if(arg == "--port" && hasValue) {
+            port = atoi(argv[++i]);
+        } else if(arg == "--local") {
+            local = true;
+        } else if(arg == "--socket" && hasValue) {
+            local = true;
+            socketPath = argv[++i];
+        } else if(arg == "--redundancy" && hasValue) {
+            redundancy = atoi(argv[++i]);
+        } else if(arg == "--jitter-buffer") {
+            jitterBuffer = true;
+        } else if(arg == "--predict") {
+            predict = true;
+        } else if(arg == "--sync-spin" && hasValue) {
+            syncSpin = atoi(argv[++i]);
+        } else if(arg == "--profile" && hasValue) {
+            profilePath = argv[++i];
+        } else if(arg == "--record" && hasValue) {
+            recordPath = argv[++i];
+        } else if(arg == "--metrics-port" && hasValue) {
+            metricsPort = atoi(argv[++i]);
+        } else if(arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if(arg == "--verbose") {
+            verbose = true;
+        } else {
+            usage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    if(!tracePath.empty() && !Trace::isEnabled())
+        fprintf(stderr, "Built without OPENRUDDER_TRACE, %s will have no events\n", tracePath.c_str());
+    Trace::setThreadName("input");
+
+    // SIGINT/SIGTERM come in through the loop so shutdown destroys the uinput devices cleanly, SIGUSR1 dumps the trace
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    const int signalFileDescriptor = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if(signalFileDescriptor < 0) {
+        fprintf(stderr, "Can't watch signals: %s\n", strerror(errno));
+        return 1;
+    }
+
+    LinuxGamepadDriver driver;
+    driver.setJitterBufferEnabled(jitterBuffer);
+    driver.setStickPredictionEnabled(predict);
+    driver.setSyncSpin(syncSpin);
+    if(!profilePath.empty() && !loadProfile(driver, profilePath))
+        return 1;
+    if(!recordPath.empty() && !driver.startRecording(recordPath))
+        return 1;
+
+    std::unique_ptr<AbstractTransceiver> transceiver;
+    if(local)
+        transceiver.reset(new SharedMemoryTransceiver(AbstractTransceiver::Slave, socketPath));
+    else
+        transceiver.reset(new UdpTransceiver(interfaceAddress, port));
+    bool running = true;
+    SessionParameters capabilities = driver.capabilities();
+    capabilities.m_redundancy = redundancy;
+    transceiver->setCapabilities(capabilities);
+    driver.setLinkQuality(&transceiver->linkQuality());
+    transceiver->sessionNegotiated.connect([verbose] (SessionParameters session) {
+        if(verbose)
+            printf("Session: codec %u, %u Hz, %u bit axes, redundancy %u, channels %#x\n", session.m_codecVersion, session.m_tickRateHz,
+                   session.m_axisBits, session.m_redundancy, session.m_channels);
+    });
+    transceiver->dataArrived.connect([&driver] (std::vector<uint8_t> data) {
+        driver.onDataArrived(data);
+    });
+    transceiver->controlArrived.connect([&driver] (std::vector<uint8_t> data) {
+        driver.onControlArrived(data);
+    });
+    transceiver->connected.connect([&driver, verbose] () {
+        if(verbose)
+            printf("Connected\n");
+        driver.onConnected();
+    });
+    transceiver->disconnected.connect([&driver, verbose] (std::string) {
+        if(verbose)
+            printf("Disconnected\n");
+        driver.onDisconnect();
+    });
+    transceiver->error.connect([] (std::string error) {
+        fprintf(stderr, "%s\n", error.c_str());
+    });
+    transceiver->closeCalled.connect([&running] () {
+        running = false;
+    });
+    driver.feedback.connect([&transceiver] (std::vector<uint8_t> data) {
+        transceiver->sendData(data);
+    });
+
+    transceiver->onStart();
+    if(transceiver->fileDescriptor() < 0)
+        return 1;
+    // Scrapes run on the server's own thread and only read the counters
+    Metrics::Server metrics;
+    if(metricsPort && !metrics.start(metricsPort)) {
+        fprintf(stderr, "Can't serve metrics on port %u\n", unsigned(metricsPort));
+        return 1;
+    }
+
+    // One loop for every descriptor, the tag is the handler to run
+    enum Source { Signals, Socket, Timers, Feedback, Macros, Sync };
+    const int epollFileDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    if(epollFileDescriptor < 0) {
+        fprintf(stderr, "Can't create the event loop: %s\n", strerror(errno));
+        return 1;
+    }
+    const struct { Source source; int fileDescriptor; const char *name; } sources[] = {
+        {Signals, signalFileDescriptor, "signals"},
+        {Socket, transceiver->fileDescriptor(), "transport"},
+        {Timers, TimerWheel::current()->fileDescriptor(), "timers"},
+        {Feedback, driver.feedbackFileDescriptor(), "uinput device"},
+        {Macros, driver.macroFileDescriptor(), "macro timer"},
+        {Sync, driver.syncFileDescriptor(), "sync tick"},
+    };
+    // Every source is needed, a loop missing one would wait forever on what it should have handled
+    for(const auto &entry: sources) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u32 = entry.source;
+        if(entry.fileDescriptor < 0 || epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, entry.fileDescriptor, &event) < 0) {
+            fprintf(stderr, "Can't watch the %s: %s\n", entry.name, entry.fileDescriptor < 0 ? "not open" : strerror(errno));
+            close(epollFileDescriptor);
+            close(signalFileDescriptor);
+            return 1;
+        }
+    }
+
+    struct epoll_event events[8];
+    while(running) {
+        const int count = epoll_wait(epollFileDescriptor, events, 8, -1);
+        if(count < 0 && errno != EINTR) {
+            fprintf(stderr, "Event loop failed: %s\n", strerror(errno));
+            break;
+        }
+        for(int i = 0; i < count && running; ++i) {
+            switch(events[i].data.u32) {
+                case Signals: {
+                    struct signalfd_siginfo info;
+                    while(read(signalFileDescriptor, &info, sizeof(info)) == sizeof(info)) {
+                        if(info.ssi_signo != SIGUSR1)
+                            running = false;
+                        else if(!tracePath.empty() && !Trace::dump(tracePath))
+                            fprintf(stderr, "Can't write trace %s\n", tracePath.c_str());
+                    }
+                    break;
+                }
+                case Socket: {
+                    transceiver->onReadable();
+                    break;
+                }
+                case Timers: {
+                    TimerWheel::current()->onReadable();
+                    break;
+                }
+                case Feedback: {
+                    driver.onFeedbackReadable();
+                    break;
+                }
+                case Macros: {
+                    driver.onMacroReadable();
+                    break;
+                }
+                case Sync: {
+                    driver.onSyncReadable();
+                    break;
+                }
+            }
+        }
+    }
+
+    // Tells a connected master we're gone and removes the local socket
+    transceiver->onStop();
+    driver.stopRecording();
+    if(!tracePath.empty() && !Trace::dump(tracePath))
+        fprintf(stderr, "Can't write trace %s\n", tracePath.c_str());
+    close(epollFileDescriptor);
+    close(signalFileDescriptor);
+    return 0;
+}
@@ -1,6 +1,6 @@
 #include "abstractdriver.h"
 
-AbstractDriver::AbstractDriver(QObject *parent) : QObject(parent)
+AbstractDriver::AbstractDriver()
 {
 
 }
@@ -6,12 +6,26 @@
 class AbstractDriver {
 public:
     explicit AbstractDriver();
+    virtual ~AbstractDriver() {}
 
 //slots
 public:
     virtual void onDataArrived(const std::vector<uint8_t> &data) = 0;
     virtual void onConnected() = 0;
     virtual void onDisconnect() = 0;
+    // Control messages from the controller, input never comes through here
+    virtual void onControlArrived(const std::vector<uint8_t> &/*data*/) {}
+
+public:
+    // Drivers with a back channel expose a descriptor for the host loop to poll,
+    // onFeedbackReadable drains it and emits feedback with data ready to send
+    virtual int feedbackFileDescriptor() const { return -1; }
+    virtual void onFeedbackReadable() {}
+    // Pushes out anything still buffered, for hosts feeding data without an event loop
+    virtual void flush() {}
+
+//signals
+    sigslot::signal<std::vector<uint8_t>> feedback;
 };
 
 #endif // ABSTRACTDRIVER_H
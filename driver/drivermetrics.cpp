@@ -0,0 +1,41 @@
+#include "drivermetrics.h"
+
+DriverMetrics::DriverMetrics(): m_published(false) {
+}
+
+DriverMetrics::~DriverMetrics() {
+    if(!m_published)
+        return;
+    Metrics::Registry *registry = Metrics::Registry::instance();
+    registry->remove(&m_packetsReceived);
+    registry->remove(&m_bytesReceived);
+    registry->remove(&m_decodeErrors);
+    registry->remove(&m_outOfOrder);
+    registry->remove(&m_uinputWrites);
+    registry->remove(&m_uinputWriteFailures);
+    registry->remove(&m_uinputWouldBlock);
+    registry->remove(&m_syncTicks);
+    registry->remove(&m_syncMissed);
+    registry->remove(&m_syncLastErrorns);
+    registry->remove(&m_syncMaxErrorns);
+    registry->remove(&m_syncMeanErrorns);
+}
+
+void DriverMetrics::publish(const std::string &labels) {
+    if(m_published)
+        return;
+    m_published = true;
+    Metrics::Registry *registry = Metrics::Registry::instance();
+    registry->add("openrudder_driver_packets_received_total", "Input datagrams handed to the driver", labels, &m_packetsReceived);
+    registry->add("openrudder_driver_bytes_received_total", "Input bytes handed to the driver", labels, &m_bytesReceived);
+    registry->add("openrudder_driver_decode_errors_total", "Input datagrams that didn't decode", labels, &m_decodeErrors);
+    registry->add("openrudder_driver_out_of_order_total", "Stick updates older than one already applied", labels, &m_outOfOrder);
+    registry->add("openrudder_driver_uinput_writes_total", "Frames written to uinput", labels, &m_uinputWrites);
+    registry->add("openrudder_driver_uinput_write_failures_total", "Frames uinput refused", labels, &m_uinputWriteFailures);
+    registry->add("openrudder_driver_uinput_would_block_total", "Frames refused with EAGAIN", labels, &m_uinputWouldBlock);
+    registry->add("openrudder_driver_sync_ticks_total", "Sync tick wakeups", labels, &m_syncTicks);
+    registry->add("openrudder_driver_sync_missed_total", "Sync periods that passed without a wakeup", labels, &m_syncMissed);
+    registry->add("openrudder_driver_sync_last_error_ns", "How late the latest sync tick ran", labels, &m_syncLastErrorns);
+    registry->add("openrudder_driver_sync_max_error_ns", "Latest a sync tick has run", labels, &m_syncMaxErrorns);
+    registry->add("openrudder_driver_sync_mean_error_ns", "Mean lateness of the sync tick", labels, &m_syncMeanErrorns);
+}
@@ -0,0 +1,35 @@
+#ifndef DRIVERMETRICS_H
+#define DRIVERMETRICS_H
+
+#include "common/metrics.h"
+
+// Counters and gauges of the driver's input thread, the only thread writing them
+struct DriverMetrics {
+    DriverMetrics();
+    ~DriverMetrics();
+    DriverMetrics(const DriverMetrics &) = delete;
+    DriverMetrics &operator=(const DriverMetrics &) = delete;
+
+    void publish(const std::string &labels);
+
+    Metrics::Counter m_packetsReceived;
+    Metrics::Counter m_bytesReceived;
+    Metrics::Counter m_decodeErrors;
+    // Stick updates stamped earlier than one already applied
+    Metrics::Counter m_outOfOrder;
+    Metrics::Counter m_uinputWrites;
+    Metrics::Counter m_uinputWriteFailures;
+    // Failures that were the non-blocking device being full, a subset of the above
+    Metrics::Counter m_uinputWouldBlock;
+    // Sync tick wakeups, mirrored from its PreciseTick::Stats
+    Metrics::Counter m_syncTicks;
+    Metrics::Counter m_syncMissed;
+    Metrics::Gauge m_syncLastErrorns;
+    Metrics::Gauge m_syncMaxErrorns;
+    Metrics::Gauge m_syncMeanErrorns;
+
+private:
+    bool m_published;
+};
+
+#endif // DRIVERMETRICS_H
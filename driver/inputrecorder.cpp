@@ -0,0 +1,218 @@
+#include "inputrecorder.h"
+#include "common/common.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const size_t FlushThreshold = 64 * 1024;
+
+const uint32_t InputRecorder::FlushPeriodms;
+
+InputRecorder::InputRecorder(): m_fileDescriptor(-1), m_offset(0), m_records(0), m_elapsed(0), m_lastTimestamp(0) {
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushPeriodms);
+    m_flushTimer.setCallback([this] () { flush(); });
+}
+
+InputRecorder::~InputRecorder() {
+    close();
+}
+
+bool InputRecorder::open(const std::string &path) {
+    close();
+    m_fileDescriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(m_fileDescriptor < 0) {
+        printf("error: opening input log %s\n", path.c_str());
+        return false;
+    }
+
+    InputLog::FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, InputLog::Magic, sizeof(header.magic));
+    header.version = InputLog::Version;
+
+    m_buffer.clear();
+    m_buffer.reserve(FlushThreshold + 4096);
+    m_buffer.insert(m_buffer.end(), (const uint8_t*)&header, (const uint8_t*)&header + sizeof(header));
+    m_offset = sizeof(header);
+    m_records = 0;
+    m_elapsed = 0;
+    m_index.clear();
+    return true;
+}
+
+void InputRecorder::close() {
+    if(m_fileDescriptor < 0)
+        return;
+
+    InputLog::Footer footer;
+    footer.indexOffset = m_offset;
+    footer.indexCount = m_index.size();
+    footer.magic = InputLog::FooterMagic;
+    const uint8_t *index = (const uint8_t*)m_index.data();
+    m_buffer.insert(m_buffer.end(), index, index + m_index.size() * sizeof(InputLog::IndexEntry));
+    m_buffer.insert(m_buffer.end(), (const uint8_t*)&footer, (const uint8_t*)&footer + sizeof(footer));
+    flush();
+
+    ::close(m_fileDescriptor);
+    m_fileDescriptor = -1;
+}
+
+bool InputRecorder::isOpen() const {
+    return m_fileDescriptor >= 0;
+}
+
+void InputRecorder::append(const std::vector<uint8_t> &data, const uint32_t &timestamp) {
+    if(m_fileDescriptor < 0)
+        return;
+
+    if(m_records > 0) {
+        const int32_t delta = timestampDelta(timestamp, m_lastTimestamp);
+        m_elapsed += delta > 0 ? delta : 0;
+    }
+    m_lastTimestamp = timestamp;
+    if(m_records % InputLog::IndexStride == 0)
+        m_index.push_back({m_offset, m_elapsed});
+    ++m_records;
+
+    InputLog::Record record;
+    record.timestamp = timestamp;
+    record.size = data.size();
+    const size_t padded = InputLog::paddedSize(data.size());
+    m_buffer.insert(m_buffer.end(), (const uint8_t*)&record, (const uint8_t*)&record + sizeof(record));
+    m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+    m_buffer.resize(m_buffer.size() + padded - data.size(), 0);
+    m_offset += sizeof(record) + padded;
+
+    if(m_buffer.size() >= FlushThreshold)
+        flush();
+    else if(!m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void InputRecorder::flush() {
+    m_flushTimer.stop();
+    size_t written = 0;
+    while(written < m_buffer.size()) {
+        const ssize_t result = write(m_fileDescriptor, m_buffer.data() + written, m_buffer.size() - written);
+        if(result < 0) {
+            printf("error: input log write");
+            break;
+        }
+        written += result;
+    }
+    m_buffer.clear();
+}
+
+InputLogReader::InputLogReader(): m_map(nullptr), m_mapSize(0), m_recordsEnd(0), m_index(nullptr), m_indexCount(0), m_position(0), m_elapsed(0), m_lastTimestamp(0), m_first(true) {
+}
+
+InputLogReader::~InputLogReader() {
+    close();
+}
+
+bool InputLogReader::open(const std::string &path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        printf("error: opening input log %s\n", path.c_str());
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(InputLog::FileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(map == MAP_FAILED)
+        return false;
+    m_map = (const uint8_t*)map;
+    m_mapSize = st.st_size;
+    madvise(map, m_mapSize, MADV_SEQUENTIAL);
+
+    const InputLog::FileHeader *header = (const InputLog::FileHeader*)m_map;
+    if(memcmp(header->magic, InputLog::Magic, sizeof(header->magic)) != 0 || header->version != InputLog::Version) {
+        printf("error: %s is not an input log\n", path.c_str());
+        close();
+        return false;
+    }
+
+    // Without a valid footer the recording was cut short, records are still usable up to the end
+    m_recordsEnd = m_mapSize;
+    if(m_mapSize >= sizeof(InputLog::FileHeader) + sizeof(InputLog::Footer)) {
+        const InputLog::Footer *footer = (const InputLog::Footer*)(m_map + m_mapSize - sizeof(InputLog::Footer));
+        const uint64_t indexEnd = footer->indexOffset + uint64_t(footer->indexCount) * sizeof(InputLog::IndexEntry);
+        if(footer->magic == InputLog::FooterMagic && footer->indexOffset >= sizeof(InputLog::FileHeader) && indexEnd == m_mapSize - sizeof(InputLog::Footer)) {
+            m_recordsEnd = footer->indexOffset;
+            m_index = (const InputLog::IndexEntry*)(m_map + footer->indexOffset);
+            m_indexCount = footer->indexCount;
+        }
+    }
+
+    rewind();
+    return true;
+}
+
+void InputLogReader::close() {
+    if(m_map)
+        munmap((void*)m_map, m_mapSize);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_recordsEnd = 0;
+    m_index = nullptr;
+    m_indexCount = 0;
+}
+
+bool InputLogReader::isOpen() const {
+    return m_map != nullptr;
+}
+
+void InputLogReader::rewind() {
+    m_position = sizeof(InputLog::FileHeader);
+    m_elapsed = 0;
+    m_first = true;
+}
+
+void InputLogReader::seek(const uint64_t &elapsed) {
+    rewind();
+    if(!m_index || m_indexCount == 0)
+        return;
+    // Entries are in elapsed order, binary search the last one not past the target
+    uint32_t low = 0, high = m_indexCount;
+    while(high - low > 1) {
+        const uint32_t mid = (low + high) / 2;
+        if(m_index[mid].elapsed <= elapsed)
+            low = mid;
+        else
+            high = mid;
+    }
+    m_position = m_index[low].offset;
+    m_elapsed = m_index[low].elapsed;
+}
+
+bool InputLogReader::next(Frame &frame) {
+    if(!m_map || m_position + sizeof(InputLog::Record) > m_recordsEnd)
+        return false;
+    const InputLog::Record *record = (const InputLog::Record*)(m_map + m_position);
+    const size_t padded = InputLog::paddedSize(record->size);
+    if(m_position + sizeof(InputLog::Record) + padded > m_recordsEnd)
+        return false;
+
+    if(!m_first) {
+        const int32_t delta = timestampDelta(record->timestamp, m_lastTimestamp);
+        m_elapsed += delta > 0 ? delta : 0;
+    }
+    m_first = false;
+    m_lastTimestamp = record->timestamp;
+
+    frame.timestamp = record->timestamp;
+    frame.elapsed = m_elapsed;
+    frame.data = m_map + m_position + sizeof(InputLog::Record);
+    frame.size = record->size;
+    m_position += sizeof(InputLog::Record) + padded;
+    return true;
+}
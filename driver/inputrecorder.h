@@ -0,0 +1,115 @@
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include "common/timerwheel.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Session log layout, everything little endian and 8 byte aligned so it can be read straight from an mmap:
+//   FileHeader
+//   Record, payload padded to 8 bytes   (repeated)
+//   IndexEntry                          (repeated, written on close)
+//   Footer
+// A log cut short by a crash has no index but the records still walk sequentially
+namespace InputLog {
+    static const char Magic[8] = {'O', 'R', 'R', 'E', 'C', 'L', 'O', 'G'};
+    static const uint32_t Version = 1;
+    static const uint32_t FooterMagic = 0x58444e49; // "INDX"
+    // One seek point per this many records
+    static const uint32_t IndexStride = 256;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct Record {
+        uint32_t timestamp; // monotonicMicros() when the datagram arrived
+        uint32_t size;      // Payload bytes, excluding padding
+    };
+
+    struct IndexEntry {
+        uint64_t offset;    // File offset of the record
+        uint64_t elapsed;   // µs since the first record
+    };
+
+    struct Footer {
+        uint64_t indexOffset;
+        uint32_t indexCount;
+        uint32_t magic;
+    };
+
+    static inline size_t paddedSize(const size_t &size) {
+        return (size + 7) & ~size_t(7);
+    }
+}
+
+// Append-only writer, buffered so recording adds no syscall per frame. A frame reaches the file
+// within FlushPeriodms even when input stops, so a crash loses at most that much.
+// Runs on the thread that opened it, the flush timer is on that thread's wheel
+class InputRecorder {
+public:
+    static const uint32_t FlushPeriodms = 100;
+
+    InputRecorder();
+    ~InputRecorder();
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+
+    void append(const std::vector<uint8_t> &data, const uint32_t &timestamp);
+
+private:
+    void flush();
+
+    int m_fileDescriptor;
+    std::vector<uint8_t> m_buffer;
+    // Armed by the first frame buffered since the last flush
+    TimerWheel::Timer m_flushTimer;
+    uint64_t m_offset;
+    uint64_t m_records;
+    uint64_t m_elapsed;
+    uint32_t m_lastTimestamp;
+    std::vector<InputLog::IndexEntry> m_index;
+};
+
+// Read side, maps the whole log and walks records in place
+class InputLogReader {
+public:
+    struct Frame {
+        uint32_t timestamp;
+        uint64_t elapsed;
+        const uint8_t *data;
+        uint32_t size;
+    };
+
+    InputLogReader();
+    ~InputLogReader();
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+
+    // Jumps to the last indexed record at or before elapsed µs, then next() walks from there
+    void seek(const uint64_t &elapsed);
+    void rewind();
+    bool next(Frame &frame);
+
+private:
+    const uint8_t *m_map;
+    size_t m_mapSize;
+    // End of the record area, the index starts here when there is one
+    size_t m_recordsEnd;
+    const InputLog::IndexEntry *m_index;
+    uint32_t m_indexCount;
+    size_t m_position;
+    uint64_t m_elapsed;
+    uint32_t m_lastTimestamp;
+    bool m_first;
+};
+
+#endif // INPUTRECORDER_H
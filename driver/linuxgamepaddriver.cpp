@@ -1,66 +1,138 @@
 #include "linuxgamepaddriver.h"
-//#include "event/gamepadevent.h"
+#include "common/trace.h"
+#include "event/gamepadevent.h"
+#include "event/rumbleevent.h"
+#include "event/controlmessage.h"
+#include <math.h>
 
 #define STICK_MAX_VAL 1024
 #define STICK_FLAT_VAL 0
 #define STICK_FUZZ_VAL 0
+#define TRIGGER_MAX_VAL GamepadEvent::TriggerMax
 
-inline __u16 mapButton2Input(const Button &btn) {
-    switch (btn) {
-    case Button::X: return BTN_X;
-    case Button::Y: return BTN_Y;
-    case Button::A: return BTN_A;
-    case Button::B: return BTN_B;
-    case Button::UP: return BTN_DPAD_UP;
-    case Button::DOWN: return BTN_DPAD_DOWN;
-    case Button::LEFT: return BTN_DPAD_LEFT;
-    case Button::RIGHT: return BTN_DPAD_RIGHT;
-    case Button::BACK: return BTN_SELECT;
-    case Button::START: return BTN_START;
-    case Button::LEFTTRIGGER: return BTN_TL;
-    case Button::RIGHTTRIGGER: return BTN_TR;
-    case Button::LEFTBUMPER: return BTN_TL2;
-    case Button::RIGHTBUMPER: return BTN_TR2;
-    }
-}
-
-LinuxGamepadDriver::LinuxGamepadDriver(): AbstractDriver(), m_syncPeriodms(1) {
-    m_syncReportTimer.setInterval(m_syncPeriodms);
-    m_syncReportTimer.setSingleShot(true);
-    connect(&m_syncReportTimer, &QTimer::timeout, this, &LinuxGamepadDriver::writeSyncReport);
+// evdev key per button, every entry of BUTTONS_DEFINITIONS needs one or the table below won't compile.
+// 0 marks buttons that never reach uinput as a key
+#define BUTTON_INPUT_X BTN_X
+#define BUTTON_INPUT_Y BTN_Y
+#define BUTTON_INPUT_B BTN_B
+#define BUTTON_INPUT_A BTN_A
+#define BUTTON_INPUT_START BTN_START
+#define BUTTON_INPUT_BACK BTN_SELECT
+#define BUTTON_INPUT_GUIDE BTN_MODE
+#define BUTTON_INPUT_LEFTTRIGGER BTN_TL
+#define BUTTON_INPUT_RIGHTTRIGGER BTN_TR
+#define BUTTON_INPUT_LEFTBUMPER BTN_TL2
+#define BUTTON_INPUT_RIGHTBUMPER BTN_TR2
+#define BUTTON_INPUT_UP BTN_DPAD_UP
+#define BUTTON_INPUT_DOWN BTN_DPAD_DOWN
+#define BUTTON_INPUT_LEFT BTN_DPAD_LEFT
+#define BUTTON_INPUT_RIGHT BTN_DPAD_RIGHT
+#define BUTTON_INPUT_LEFTSTICK BTN_THUMBL
+#define BUTTON_INPUT_RIGHTSTICK BTN_THUMBR
+#define BUTTON_INPUT_DPAD 0
+#define BUTTON_INPUT_COUNT 0
+
+constexpr __u16 ButtonInputCodes[ButtonTables::Count] = {
+#define BUTTON_DEF(x, y) BUTTON_INPUT_##x,
+BUTTONS_DEFINITIONS
+#undef BUTTON_DEF
+};
+
+LinuxGamepadDriver::LinuxGamepadDriver(): AbstractDriver(), m_syncPeriodms(1), m_frameSize(0), m_jitterBufferEnabled(false), m_stickPredictionEnabled(false), m_predictionPeriodms(4), m_ffGain(0xffff), m_remap(ButtonInputCodes), m_heldButtons(0), m_liveButtons(0), m_linkQuality(nullptr), m_created(false) {
+    memset(m_pressedCodes, 0, sizeof(m_pressedCodes));
+    memset(m_chordCodes, 0, sizeof(m_chordCodes));
+    memset(m_effects, 0, sizeof(m_effects));
+    memset(m_effectLengths, 0, sizeof(m_effectLengths));
+    memset(m_effectUsed, 0, sizeof(m_effectUsed));
+    m_stickTimestamps[0] = m_stickTimestamps[1] = 0;
+    m_metrics.publish("device=\"gamepad\"");
+    m_syncTick.setPeriod(m_syncPeriodms * 1000);
+    m_syncTick.setCallback([this] () { onSyncTick(); });
+    m_playoutTimer.setSingleShot(true);
+    m_playoutTimer.setCallback([this] () { onPlayoutTimeout(); });
+    m_predictionTimer.setInterval(m_predictionPeriodms);
+    m_predictionTimer.setCallback([this] () { onPredictionTimeout(); });
     init();
 }
 
 LinuxGamepadDriver::~LinuxGamepadDriver() {
-    if(ioctl(m_fileDescriptor, UI_DEV_DESTROY) < 0) {
+    if(m_created && ioctl(m_fileDescriptor, UI_DEV_DESTROY) < 0) {
         printf("error: ioctl");
     }
-    close(m_fileDescriptor);
+    if(m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+}
+
+bool LinuxGamepadDriver::isOpen() const {
+    return m_created;
 }
 
 void LinuxGamepadDriver::onDataArrived(const std::vector<uint8_t> &data) {
+    TRACE_SCOPE("driver input");
+    const uint32_t now = monotonicMicros();
+    m_metrics.m_packetsReceived.add();
+    m_metrics.m_bytesReceived.add(data.size());
+    if(m_recorder.isOpen())
+        m_recorder.append(data, now);
+    m_stickPredictor.heartbeat(now);
+    // Motion has its own device and framing, it never reaches the gamepad
+    if(MotionPacket::isMotion(data)) {
+        m_motionDevice.submit(MotionPacket(data));
+        return;
+    }
+
+    if(!GamepadEvent::isGamepadEvent(data)) {
+        m_metrics.m_decodeErrors.add();
+        return;
+    }
     GamepadEvent event(data);
 
-    const std::string btnLabel = labelForButton(event.m_button);
     switch (event.m_type) {
         case GamepadEvent::ButtonPressEvent: {
-            pressButton(event.m_button);
+            if(!m_macroEngine.press(event.m_button, monotonicNanos()))
+                m_liveButtons |= event.m_button;
+            syncButtons();
             break;
         }
         case GamepadEvent::ButtonReleaseEvent: {
-            releaseButton(event.m_button);
+            if(!m_macroEngine.release(event.m_button))
+                m_liveButtons &= ~uint32_t(event.m_button);
+            syncButtons();
             break;
         }
         case GamepadEvent::StickMoveEvent: {
-            moveStick(event.m_button, event.m_value);
+            // Counted only, the jitter buffer sorts these out when it's on
+            uint32_t &lastTimestamp = m_stickTimestamps[event.m_button == Button::LEFTSTICK ? 0 : 1];
+            if(lastTimestamp != 0 && timestampDelta(event.m_timestamp, lastTimestamp) < 0)
+                m_metrics.m_outOfOrder.add();
+            else
+                lastTimestamp = event.m_timestamp;
+            if(m_linkQuality)
+                m_linkQuality->onInput(event.m_timestamp, now);
+            if(m_jitterBufferEnabled) {
+                const StickJitterBuffer::Frame frame = {event.m_button, float(event.m_value.x()), float(event.m_value.y()), event.m_timestamp};
+                m_jitterBuffer.push(frame, now);
+                schedulePlayout();
+            } else {
+                applyStick(event.m_button, event.m_value);
+            }
             break;
         }
         case GamepadEvent::StickPressEvent: {
+            // Edges bypass the jitter buffer, anything still queued for the stick is stale now
+            m_jitterBuffer.clear(event.m_button);
+            m_stickPredictor.press(event.m_button, event.m_value.x(), event.m_value.y(), now);
             moveStick(event.m_button, event.m_value);
             break;
         }
         case GamepadEvent::StickReleaseEvent: {
-            moveStick(event.m_button, QPointF(0, 0));
+            m_jitterBuffer.clear(event.m_button);
+            m_stickPredictor.release(event.m_button);
+            moveStick(event.m_button, PointF(0, 0));
+            break;
+        }
+        case GamepadEvent::TriggerMoveEvent: {
+            moveTrigger(event.m_button, event.m_trigger);
             break;
         }
         case GamepadEvent::DummyEvent: {
@@ -71,17 +143,288 @@ void LinuxGamepadDriver::onDataArrived(const std::vector<uint8_t> &data) {
 }
 
 void LinuxGamepadDriver::onConnected() {
-    m_syncReportTimer.start(m_syncPeriodms);
+    if(m_stickPredictionEnabled)
+        m_predictionTimer.start();
 }
 
 void LinuxGamepadDriver::onDisconnect() {
-    m_syncReportTimer.stop();
+    m_syncTick.stop();
+    m_playoutTimer.stop();
+    m_jitterBuffer.reset();
+    m_predictionTimer.stop();
+    m_stickPredictor.reset();
+    m_macroEngine.reset();
+    m_liveButtons = 0;
+    m_stickTimestamps[0] = m_stickTimestamps[1] = 0;
+    syncButtons();
+    writeSyncReport();
+}
+
+int LinuxGamepadDriver::feedbackFileDescriptor() const {
+    return m_fileDescriptor;
+}
+
+void LinuxGamepadDriver::onFeedbackReadable() {
+    struct input_event events[16];
+    ssize_t size;
+    // Drain everything, the fd is non-blocking and the host loop only wakes us once
+    while((size = read(m_fileDescriptor, events, sizeof(events))) > 0) {
+        const int count = size / sizeof(struct input_event);
+        for(int i = 0; i < count; ++i) {
+            const struct input_event &ev = events[i];
+            if(ev.type == EV_UINPUT && ev.code == UI_FF_UPLOAD) {
+                uploadEffect(ev.value);
+            } else if(ev.type == EV_UINPUT && ev.code == UI_FF_ERASE) {
+                eraseEffect(ev.value);
+            } else if(ev.type == EV_FF && ev.code == FF_GAIN) {
+                m_ffGain = ev.value;
+            } else if(ev.type == EV_FF) {
+                playEffect(ev.code, ev.value);
+            }
+        }
+    }
+}
+
+void LinuxGamepadDriver::uploadEffect(const __u32 &requestId) {
+    struct uinput_ff_upload upload;
+    memset(&upload, 0, sizeof(upload));
+    upload.request_id = requestId;
+    if(ioctl(m_fileDescriptor, UI_BEGIN_FF_UPLOAD, &upload) < 0) {
+        printf("error: ff-upload-begin");
+        return;
+    }
+    const __s16 id = upload.effect.id;
+    if(upload.effect.type != FF_RUMBLE || id < 0 || id >= FfEffectsMax) {
+        upload.retval = -EINVAL;
+    } else {
+        m_effects[id] = upload.effect.u.rumble;
+        m_effectLengths[id] = upload.effect.replay.length;
+        m_effectUsed[id] = true;
+        upload.retval = 0;
+    }
+    if(ioctl(m_fileDescriptor, UI_END_FF_UPLOAD, &upload) < 0) {
+        printf("error: ff-upload-end");
+    }
+}
+
+void LinuxGamepadDriver::eraseEffect(const __u32 &requestId) {
+    struct uinput_ff_erase erase;
+    memset(&erase, 0, sizeof(erase));
+    erase.request_id = requestId;
+    if(ioctl(m_fileDescriptor, UI_BEGIN_FF_ERASE, &erase) < 0) {
+        printf("error: ff-erase-begin");
+        return;
+    }
+    if(erase.effect_id < FfEffectsMax) {
+        // Stop it on the phone first if it was playing
+        if(m_effectUsed[erase.effect_id])
+            playEffect(erase.effect_id, 0);
+        m_effectUsed[erase.effect_id] = false;
+    }
+    erase.retval = 0;
+    if(ioctl(m_fileDescriptor, UI_END_FF_ERASE, &erase) < 0) {
+        printf("error: ff-erase-end");
+    }
+}
+
+void LinuxGamepadDriver::playEffect(const __u16 &id, const __s32 &count) {
+    if(id >= FfEffectsMax || !m_effectUsed[id])
+        return;
+    // Sent straight away, rumble arriving late feels broken
+    if(count <= 0) {
+        feedback(RumbleEvent().data());
+        return;
+    }
+    const struct ff_rumble_effect &effect = m_effects[id];
+    const uint16_t strong = uint32_t(effect.strong_magnitude) * m_ffGain / 0xffff;
+    const uint16_t weak = uint32_t(effect.weak_magnitude) * m_ffGain / 0xffff;
+    // A zero length plays until stopped, repeats just stretch the duration
+    const uint32_t durationms = uint32_t(m_effectLengths[id]) * count;
+    feedback(RumbleEvent(strong, weak, durationms > 0xffff ? 0xffff : durationms).data());
+}
+
+void LinuxGamepadDriver::flush() {
+    writeSyncReport();
+}
+
+bool LinuxGamepadDriver::startRecording(const std::string &path) {
+    return m_recorder.open(path);
+}
+
+void LinuxGamepadDriver::stopRecording() {
+    m_recorder.close();
+}
+
+bool LinuxGamepadDriver::isRecording() const {
+    return m_recorder.isOpen();
+}
+
+void LinuxGamepadDriver::setRemapProfile(const RemapProfile &profile) {
+    m_remap.setProfile(profile);
+}
+
+bool LinuxGamepadDriver::setRemapProfile(const std::string &text, std::string &error) {
+    RemapProfile profile;
+    if(!profile.parse(text, ButtonInputCodes, error))
+        return false;
+    m_remap.setProfile(profile);
+    setMacros(profile.macros);
+    return true;
+}
+
+void LinuxGamepadDriver::resetRemapProfile() {
+    m_remap.resetProfile();
+}
+
+void LinuxGamepadDriver::setMacros(const std::vector<MacroEngine::Macro> &macros) {
+    m_macroEngine.setMacros(macros);
+    syncButtons();
+}
+
+int LinuxGamepadDriver::macroFileDescriptor() const {
+    return m_macroEngine.fileDescriptor();
+}
+
+void LinuxGamepadDriver::onMacroReadable() {
+    const uint64_t now = monotonicNanos();
+    // Each step is its own frame, written right away rather than on the sync timer
+    while(m_macroEngine.step(now)) {
+        syncButtons();
+        writeSyncReport();
+    }
+}
+
+int LinuxGamepadDriver::syncFileDescriptor() const {
+    return m_syncTick.fileDescriptor();
+}
+
+void LinuxGamepadDriver::onSyncReadable() {
+    m_syncTick.onReadable();
+}
+
+void LinuxGamepadDriver::onSyncTick() {
+    const PreciseTick::Stats stats = m_syncTick.stats();
+    m_metrics.m_syncTicks.add(stats.ticks - m_metrics.m_syncTicks.value());
+    m_metrics.m_syncMissed.add(stats.missed - m_metrics.m_syncMissed.value());
+    m_metrics.m_syncLastErrorns.set(stats.lastErrorns);
+    m_metrics.m_syncMaxErrorns.set(stats.maxErrorns);
+    m_metrics.m_syncMeanErrorns.set(stats.meanErrorns);
+
+    // A tick that finds nothing pending disarms, an idle connection costs no wakeups.
+    // Steady input keeps it running rather than re-arming the timerfd for every frame
+    if(m_frameSize == 0 && !m_keyboardDevice.hasPending())
+        m_syncTick.stop();
+    else
+        writeSyncReport();
+}
+
+void LinuxGamepadDriver::setSyncSpin(const uint32_t &us) {
+    m_syncTick.setSpin(us);
+}
+
+const DriverMetrics &LinuxGamepadDriver::metrics() const {
+    return m_metrics;
+}
+
+void LinuxGamepadDriver::setLinkQuality(LinkQuality *linkQuality) {
+    m_linkQuality = linkQuality;
+}
+
+SessionParameters LinuxGamepadDriver::capabilities() const {
+    // One update per sync period is all the device takes, sticks span 2 * STICK_MAX_VAL + 1 steps
+    int axisBits = 1;
+    while((1 << axisBits) < 2 * STICK_MAX_VAL + 1)
+        ++axisBits;
+    return SessionParameters(SessionParameters::LatestCodec, 1000 / m_syncPeriodms, axisBits);
+}
+
+void LinuxGamepadDriver::onControlArrived(const std::vector<uint8_t> &data) {
+    // Control traffic, ping replies included, keeps the sticks alive through input lulls
+    m_stickPredictor.heartbeat(monotonicMicros());
+    const ControlMessage message(data);
+    if(message.m_opcode != ControlMessage::Config)
+        return;
+    uint32_t value;
+    if(message.value(ControlMessage::JitterBuffer, value))
+        setJitterBufferEnabled(value != 0);
+    if(message.value(ControlMessage::StickPrediction, value))
+        setStickPredictionEnabled(value != 0);
+}
+
+void LinuxGamepadDriver::setJitterBufferEnabled(const bool &enabled) {
+    m_jitterBufferEnabled = enabled;
+    m_playoutTimer.stop();
+    m_jitterBuffer.reset();
+}
+
+bool LinuxGamepadDriver::jitterBufferEnabled() const {
+    return m_jitterBufferEnabled;
+}
+
+void LinuxGamepadDriver::setStickPredictionEnabled(const bool &enabled) {
+    m_stickPredictionEnabled = enabled;
+    m_stickPredictor.reset();
+    if(enabled)
+        m_predictionTimer.start();
+    else
+        m_predictionTimer.stop();
+}
+
+bool LinuxGamepadDriver::stickPredictionEnabled() const {
+    return m_stickPredictionEnabled;
+}
+
+void LinuxGamepadDriver::applyStick(const Button &btn, const PointF &value) {
+    if(!m_stickPredictionEnabled) {
+        moveStick(btn, value);
+        return;
+    }
+    float x, y;
+    m_stickPredictor.update(btn, value.x(), value.y(), monotonicMicros(), x, y);
+    moveStick(btn, PointF(x, y));
+}
+
+void LinuxGamepadDriver::schedulePlayout() {
+    uint32_t deadline;
+    if(!m_jitterBuffer.nextDeadline(deadline)) {
+        m_playoutTimer.stop();
+        return;
+    }
+    const int32_t remainingus = timestampDelta(deadline, monotonicMicros());
+    m_playoutTimer.start(remainingus > 0 ? (remainingus + 999) / 1000 : 0);
+}
+
+void LinuxGamepadDriver::onPlayoutTimeout() {
+    StickJitterBuffer::Frame frame;
+    const uint32_t now = monotonicMicros();
+    while(m_jitterBuffer.pop(now, frame))
+        applyStick(frame.stick, PointF(frame.x, frame.y));
+    schedulePlayout();
+}
+
+void LinuxGamepadDriver::onPredictionTimeout() {
+    const uint32_t now = monotonicMicros();
+    const Button sticks[] = {Button::LEFTSTICK, Button::RIGHTSTICK};
+    for(const Button &stick: sticks) {
+        if(m_stickPredictor.heartbeatExpired(now)) {
+            // Controller went silent, don't leave the character walking
+            if(m_stickPredictor.active(stick)) {
+                m_stickPredictor.release(stick);
+                moveStick(stick, PointF(0, 0));
+            }
+            continue;
+        }
+        float x, y;
+        if(m_stickPredictor.extrapolate(stick, now, x, y))
+            moveStick(stick, PointF(x, y));
+    }
 }
 
 void LinuxGamepadDriver::init() {
-    m_fileDescriptor = open("/dev/uinput", O_WRONLY | O_NONBLOCK); //opening of uinput
+    m_fileDescriptor = open("/dev/uinput", O_RDWR | O_NONBLOCK); //opening of uinput, read side carries force feedback
     if (m_fileDescriptor < 0) {
         printf("Opening of uinput failed!\n");
+        return;
     }
     ioctl(m_fileDescriptor, UI_SET_EVBIT, EV_KEY); //setting Gamepad keys
     ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_A);
@@ -94,6 +437,7 @@ void LinuxGamepadDriver::init() {
     ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_TR2);
     ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_START);
     ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_SELECT);
+    ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_MODE);
     ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_THUMBL);
     ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_THUMBR);
     ioctl(m_fileDescriptor, UI_SET_KEYBIT, BTN_DPAD_UP);
@@ -105,6 +449,11 @@ void LinuxGamepadDriver::init() {
     ioctl(m_fileDescriptor, UI_SET_ABSBIT, ABS_Y);
     ioctl(m_fileDescriptor, UI_SET_ABSBIT, ABS_RX);
     ioctl(m_fileDescriptor, UI_SET_ABSBIT, ABS_RY);
+    ioctl(m_fileDescriptor, UI_SET_ABSBIT, ABS_Z); //setting analog triggers
+    ioctl(m_fileDescriptor, UI_SET_ABSBIT, ABS_RZ);
+    ioctl(m_fileDescriptor, UI_SET_EVBIT, EV_FF); //setting force feedback
+    ioctl(m_fileDescriptor, UI_SET_FFBIT, FF_RUMBLE);
+    ioctl(m_fileDescriptor, UI_SET_FFBIT, FF_GAIN);
     struct uinput_user_dev uidev; //setting the default settings of Gamepad
     memset(&uidev, 0, sizeof(uidev));
     snprintf(uidev.name, UINPUT_MAX_NAME_SIZE, "Gamepad Emulator"); //Name of Gamepad
@@ -128,6 +477,11 @@ void LinuxGamepadDriver::init() {
     uidev.absmin[ABS_RY] = -STICK_MAX_VAL;
     uidev.absfuzz[ABS_RY] = STICK_FUZZ_VAL;
     uidev.absflat[ABS_RY] = STICK_FLAT_VAL;
+    uidev.absmax[ABS_Z] = TRIGGER_MAX_VAL; //Parameters of triggers
+    uidev.absmin[ABS_Z] = 0;
+    uidev.absmax[ABS_RZ] = TRIGGER_MAX_VAL;
+    uidev.absmin[ABS_RZ] = 0;
+    uidev.ff_effects_max = FfEffectsMax;
     if(write(m_fileDescriptor, &uidev, sizeof(uidev)) < 0) //writing settings
     {
         printf("error: write");
@@ -135,66 +489,122 @@ void LinuxGamepadDriver::init() {
     if(ioctl(m_fileDescriptor, UI_DEV_CREATE) < 0) //writing ui dev create
     {
         printf("error: ui_dev_create");
+        return;
     }
+    m_created = true;
 }
 
 void LinuxGamepadDriver::writeSyncReport() {
-    memset(&m_ev, 0, sizeof(struct input_event));
-    m_ev.type = EV_SYN;
-    m_ev.code = SYN_REPORT;
-    m_ev.value = 0;
-    if(write(m_fileDescriptor, &m_ev, sizeof(struct input_event)) < 0) //writing the sync report
+    m_keyboardDevice.flush();
+    if(m_frameSize == 0)
+        return;
+    TRACE_SCOPE("SYN_REPORT");
+    queueEvent(EV_SYN, SYN_REPORT, 0);
+    m_metrics.m_uinputWrites.add();
+    if(write(m_fileDescriptor, m_frame, m_frameSize * sizeof(struct input_event)) < 0) //writing the whole frame
     {
-        printf("error: sync-report");
+        m_metrics.m_uinputWriteFailures.add();
+        if(errno == EAGAIN)
+            m_metrics.m_uinputWouldBlock.add();
+        else
+            printf("error: frame-write");
     }
+    m_frameSize = 0;
 }
 
-void LinuxGamepadDriver::moveStick(const Button &btn, const QPointF &value) {
-    // X axis
-    memset(&m_ev, 0, sizeof(struct input_event)); //setting the memory for event
-    m_ev.type = EV_ABS;
-    m_ev.code = btn == Button::LEFTSTICK ? ABS_X : ABS_RX;
-    m_ev.value = value.x() * STICK_MAX_VAL;
-    if(write(m_fileDescriptor, &m_ev, sizeof(struct input_event)) < 0) //writing the thumbstick change
-    {
-        printf("error: thumbstick-write");
-    }
-    // Y axis
-    memset(&m_ev, 0, sizeof(struct input_event)); //setting the memory for event
-    m_ev.type = EV_ABS;
-    m_ev.code = btn == Button::LEFTSTICK ? ABS_Y : ABS_RY;
-    m_ev.value = value.y() * STICK_MAX_VAL;
-    if(write(m_fileDescriptor, &m_ev, sizeof(struct input_event)) < 0) //writing the thumbstick change
-    {
-        printf("error: thumbstick-write");
+void LinuxGamepadDriver::queueEvent(const __u16 &type, const __u16 &code, const __s32 &value) {
+    // The first event of a frame arms the tick, which flushes it within a sync period
+    if(type != EV_SYN && !m_syncTick.isActive())
+        m_syncTick.start();
+    // Keyboard keys go to their own device, flushed on the same tick
+    if(type == EV_KEY && code >= Remap::FirstKey && code <= Remap::LastKey) {
+        m_keyboardDevice.queue(code, value);
+        return;
     }
+    // Leave room for the SYN_REPORT, a full frame goes out early
+    if(m_frameSize == FrameCapacity - 1 && type != EV_SYN)
+        writeSyncReport();
+    struct input_event &ev = m_frame[m_frameSize++];
+    memset(&ev, 0, sizeof(struct input_event));
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+}
 
-    if(!m_syncReportTimer.isActive())
-        m_syncReportTimer.start();
+void LinuxGamepadDriver::moveStick(const Button &btn, const PointF &value) {
+    moveAxis(btn == Button::LEFTSTICK ? Remap::LeftX : Remap::RightX, value.x());
+    moveAxis(btn == Button::LEFTSTICK ? Remap::LeftY : Remap::RightY, value.y());
 }
-void LinuxGamepadDriver::pressButton(const Button &btn) {
-    memset(&m_ev, 0, sizeof(struct input_event)); //setting the memory for event
-    m_ev.type = EV_KEY;
-    m_ev.code = mapButton2Input(btn);
-    m_ev.value = 1;
-    if(write(m_fileDescriptor, &m_ev, sizeof(struct input_event)) < 0) //writing the thumbstick change
-    {
-        printf("error: key-write");
+
+void LinuxGamepadDriver::moveTrigger(const Button &btn, const int &value) {
+    moveAxis(btn == Button::LEFTTRIGGER ? Remap::LeftTrigger : Remap::RightTrigger, float(value) / TRIGGER_MAX_VAL);
+}
+
+void LinuxGamepadDriver::moveAxis(const Remap::Axis &axis, const float &value) {
+    static const __u16 AxisCodes[Remap::AxisCount] = {ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ};
+    RemapEngine::Guard remap(m_remap);
+    const CompiledRemap::AxisTarget &target = remap->axes[axis];
+    const float scaled = value * target.scale;
+    if(target.to == Remap::LeftTrigger || target.to == Remap::RightTrigger) {
+        const float clamped = scaled < 0 ? 0 : scaled > 1 ? 1 : scaled;
+        queueEvent(EV_ABS, AxisCodes[target.to], lroundf(clamped * TRIGGER_MAX_VAL));
+    } else {
+        const float clamped = scaled < -1 ? -1 : scaled > 1 ? 1 : scaled;
+        queueEvent(EV_ABS, AxisCodes[target.to], lroundf(clamped * STICK_MAX_VAL));
     }
+}
 
-    if(!m_syncReportTimer.isActive())
-        m_syncReportTimer.start();
+void LinuxGamepadDriver::pressButton(const Button &btn) {
+    const int index = buttonIndex(btn);
+    if(index < 0 || index >= ButtonTables::Count)
+        return;
+    RemapEngine::Guard remap(m_remap);
+    m_heldButtons |= btn;
+    const __u16 code = remap->buttonCodes[index];
+    if(code && !m_pressedCodes[index]) {
+        m_pressedCodes[index] = code;
+        queueEvent(EV_KEY, code, 1);
+    }
+    if(btn & remap->chordButtons)
+        updateChords(*remap);
 }
+
 void LinuxGamepadDriver::releaseButton(const Button &btn) {
-    memset(&m_ev, 0, sizeof(struct input_event)); //setting the memory for event
-    m_ev.type = EV_KEY;
-    m_ev.code = mapButton2Input(btn);
-    m_ev.value = 0;
-    if(write(m_fileDescriptor, &m_ev, sizeof(struct input_event)) < 0) //writing the thumbstick change
-    {
-        printf("error: key-write");
+    const int index = buttonIndex(btn);
+    if(index < 0 || index >= ButtonTables::Count)
+        return;
+    RemapEngine::Guard remap(m_remap);
+    m_heldButtons &= ~uint32_t(btn);
+    if(m_pressedCodes[index]) {
+        queueEvent(EV_KEY, m_pressedCodes[index], 0);
+        m_pressedCodes[index] = 0;
+    }
+    updateChords(*remap);
+}
+
+void LinuxGamepadDriver::syncButtons() {
+    const uint32_t target = m_liveButtons | m_macroEngine.buttons();
+    uint32_t changed = target ^ m_heldButtons;
+    while(changed) {
+        const Button btn = Button(changed & -changed);
+        changed &= changed - 1;
+        if(target & btn)
+            pressButton(btn);
+        else
+            releaseButton(btn);
     }
+}
 
-    if(!m_syncReportTimer.isActive())
-        m_syncReportTimer.start();
+void LinuxGamepadDriver::updateChords(const CompiledRemap &remap) {
+    for(int i = 0; i < Remap::MaxChords; ++i) {
+        const bool active = i < remap.chordCount && (m_heldButtons & remap.chords[i].buttons) == remap.chords[i].buttons;
+        const __u16 code = active ? remap.chords[i].code : 0;
+        if(code == m_chordCodes[i])
+            continue;
+        if(m_chordCodes[i])
+            queueEvent(EV_KEY, m_chordCodes[i], 0);
+        if(code)
+            queueEvent(EV_KEY, code, 1);
+        m_chordCodes[i] = code;
+    }
 }
@@ -3,6 +3,18 @@
 
 #include "driver/abstractdriver.h"
 #include "common/common.h"
+#include "common/timerwheel.h"
+#include "common/precisetick.h"
+#include "driver/stickjitterbuffer.h"
+#include "driver/stickpredictor.h"
+#include "driver/linuxmotiondevice.h"
+#include "driver/linuxkeyboarddevice.h"
+#include "driver/inputrecorder.h"
+#include "driver/remapengine.h"
+#include "driver/macroengine.h"
+#include "event/sessionparameters.h"
+#include "driver/drivermetrics.h"
+#include "transceiver/linkquality.h"
 //#include <QTimer>
 // Required headers to use uinput and linux input
 #include <stdio.h>
@@ -14,8 +26,6 @@
 #include <linux/input.h>
 #include <linux/uinput.h>
 
-#define Point int
-#define Timer int
 
 class LinuxGamepadDriver : public AbstractDriver {
 public:
@@ -27,17 +37,102 @@ public:
     void onDataArrived(const std::vector<uint8_t> &data);
     void onConnected();
     void onDisconnect();
+    void onControlArrived(const std::vector<uint8_t> &data) override;
+    // What this driver offers in the connect handshake
+    SessionParameters capabilities() const;
+    // False when /dev/uinput couldn't be opened or the device not created, every frame would fail then
+    bool isOpen() const;
+
+public:
+    int feedbackFileDescriptor() const override;
+    void onFeedbackReadable() override;
+    void flush() override;
+
+    // Optional playout buffer smoothing out stick frames that arrive in bursts, button edges bypass it
+    void setJitterBufferEnabled(const bool &enabled);
+    bool jitterBufferEnabled() const;
+    // Extrapolates sticks through short packet gaps and centers them after the heartbeat timeout
+    void setStickPredictionEnabled(const bool &enabled);
+    bool stickPredictionEnabled() const;
+    // Logs every received datagram with its arrival time, replayable with tools/inputreplay
+    bool startRecording(const std::string &path);
+    void stopRecording();
+    bool isRecording() const;
+    // Takes effect on the next event, safe to call from any thread while input is flowing
+    void setRemapProfile(const RemapProfile &profile);
+    // Parses a profile against this driver's default codes, false with error set if it doesn't parse.
+    // Its turbo and macro rules replace the macros, so unlike the above this is input thread only
+    bool setRemapProfile(const std::string &text, std::string &error);
+    void resetRemapProfile();
+    // Turbo and macros, input thread only. The host loop polls macroFileDescriptor and calls onMacroReadable
+    void setMacros(const std::vector<MacroEngine::Macro> &macros);
+    int macroFileDescriptor() const;
+    void onMacroReadable();
+    // Sync tick, polled by the host loop like the others
+    int syncFileDescriptor() const;
+    void onSyncReadable();
+    void setSyncSpin(const uint32_t &us);
+    const DriverMetrics &metrics() const;
+    // Stick timestamps are aged against it on arrival, must be written from the transceiver's thread
+    void setLinkQuality(LinkQuality *linkQuality);
 
 private:
     void init();
     void writeSyncReport();
-    void moveStick(const Button &btn, const Point &value);
+    void onSyncTick();
+    void queueEvent(const __u16 &type, const __u16 &code, const __s32 &value);
+    void moveStick(const Button &btn, const PointF &value);
+    void moveTrigger(const Button &btn, const int &value);
     void pressButton(const Button &btn);
     void releaseButton(const Button &btn);
-    Timer m_syncReportTimer;
+    void moveAxis(const Remap::Axis &axis, const float &value);
+    void updateChords(const CompiledRemap &remap);
+    void syncButtons();
+    void applyStick(const Button &btn, const PointF &value);
+    void schedulePlayout();
+    void onPlayoutTimeout();
+    void onPredictionTimeout();
+    void uploadEffect(const __u32 &requestId);
+    void eraseEffect(const __u32 &requestId);
+    void playEffect(const __u16 &id, const __s32 &count);
+    // Flushes the pending frame every sync period, armed only while events are pending
+    PreciseTick m_syncTick;
     int m_syncPeriodms;
     int m_fileDescriptor;
-    struct input_event m_ev;
+    // Events of the current frame, written together with the SYN_REPORT in a single write
+    static const int FrameCapacity = 64;
+    struct input_event m_frame[FrameCapacity];
+    int m_frameSize;
+    bool m_jitterBufferEnabled;
+    StickJitterBuffer m_jitterBuffer;
+    TimerWheel::Timer m_playoutTimer;
+    bool m_stickPredictionEnabled;
+    StickPredictor m_stickPredictor;
+    TimerWheel::Timer m_predictionTimer;
+    int m_predictionPeriodms;
+    // Rumble effects uploaded by games, indexed by effect id
+    static const int FfEffectsMax = 16;
+    struct ff_rumble_effect m_effects[FfEffectsMax];
+    __u16 m_effectLengths[FfEffectsMax];
+    bool m_effectUsed[FfEffectsMax];
+    __u16 m_ffGain;
+    LinuxMotionDevice m_motionDevice;
+    // Remapped keyboard keys, the pad itself only registers buttons so it isn't taken for a keyboard
+    LinuxKeyboardDevice m_keyboardDevice;
+    InputRecorder m_recorder;
+    RemapEngine m_remap;
+    // What was actually pressed, so releases still match after a profile swap
+    uint32_t m_heldButtons;
+    __u16 m_pressedCodes[ButtonTables::Count];
+    __u16 m_chordCodes[Remap::MaxChords];
+    MacroEngine m_macroEngine;
+    // Pressed on the controller, m_heldButtons is this OR'ed with what macros hold
+    uint32_t m_liveButtons;
+    // Newest stick timestamps applied, left then right, zero before the first one
+    uint32_t m_stickTimestamps[2];
+    DriverMetrics m_metrics;
+    LinkQuality *m_linkQuality;
+    bool m_created;
 };
 
 #endif // LINUXGAMEPADDRIVER_H
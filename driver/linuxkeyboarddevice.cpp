@@ -0,0 +1,81 @@
+#include "linuxkeyboarddevice.h"
+#include "driver/remapengine.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+LinuxKeyboardDevice::LinuxKeyboardDevice(): m_fileDescriptor(-1), m_frameSize(0) {
+    init();
+}
+
+LinuxKeyboardDevice::~LinuxKeyboardDevice() {
+    if(m_fileDescriptor < 0)
+        return;
+    if(ioctl(m_fileDescriptor, UI_DEV_DESTROY) < 0) {
+        printf("error: ioctl");
+    }
+    close(m_fileDescriptor);
+}
+
+bool LinuxKeyboardDevice::isOpen() const {
+    return m_fileDescriptor >= 0;
+}
+
+void LinuxKeyboardDevice::init() {
+    m_fileDescriptor = open("/dev/uinput", O_WRONLY | O_NONBLOCK); //opening of uinput
+    if (m_fileDescriptor < 0) {
+        printf("Opening of uinput failed!\n");
+        return;
+    }
+    ioctl(m_fileDescriptor, UI_SET_EVBIT, EV_KEY);
+    for(__u16 key = Remap::FirstKey; key <= Remap::LastKey; ++key)
+        ioctl(m_fileDescriptor, UI_SET_KEYBIT, key);
+
+    struct uinput_user_dev uidev;
+    memset(&uidev, 0, sizeof(uidev));
+    snprintf(uidev.name, UINPUT_MAX_NAME_SIZE, "Gamepad Emulator Keyboard");
+    uidev.id.bustype = BUS_USB;
+    uidev.id.vendor  = 0x3;
+    uidev.id.product = 0x3;
+    uidev.id.version = 2;
+    if(write(m_fileDescriptor, &uidev, sizeof(uidev)) < 0) //writing settings
+    {
+        printf("error: write");
+    }
+    if(ioctl(m_fileDescriptor, UI_DEV_CREATE) < 0) //writing ui dev create
+    {
+        printf("error: ui_dev_create");
+        close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+    }
+}
+
+void LinuxKeyboardDevice::queue(const __u16 &code, const __s32 &value) {
+    // Leave room for the SYN_REPORT, a full frame goes out early
+    if(m_frameSize == FrameCapacity - 1)
+        flush();
+    struct input_event &ev = m_frame[m_frameSize++];
+    memset(&ev, 0, sizeof(struct input_event));
+    ev.type = EV_KEY;
+    ev.code = code;
+    ev.value = value;
+}
+
+void LinuxKeyboardDevice::flush() {
+    if(m_frameSize == 0)
+        return;
+    struct input_event &syn = m_frame[m_frameSize++];
+    memset(&syn, 0, sizeof(struct input_event));
+    syn.type = EV_SYN;
+    syn.code = SYN_REPORT;
+    if(m_fileDescriptor >= 0 && write(m_fileDescriptor, m_frame, m_frameSize * sizeof(struct input_event)) < 0) //writing the whole frame
+    {
+        printf("error: keyboard-write");
+    }
+    m_frameSize = 0;
+}
+
+bool LinuxKeyboardDevice::hasPending() const {
+    return m_frameSize > 0;
+}
@@ -0,0 +1,29 @@
+#ifndef LINUXKEYBOARDDEVICE_H
+#define LINUXKEYBOARDDEVICE_H
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+// Separate uinput device for the keyboard keys remap profiles can target. Registered on the pad
+// they would make udev tag it as a keyboard too, and games skip those when looking for controllers
+class LinuxKeyboardDevice {
+public:
+    LinuxKeyboardDevice();
+    ~LinuxKeyboardDevice();
+
+    bool isOpen() const;
+    // Buffered until flush, which writes them with their SYN_REPORT in a single write
+    void queue(const __u16 &code, const __s32 &value);
+    void flush();
+    bool hasPending() const;
+
+private:
+    void init();
+
+    int m_fileDescriptor;
+    static const int FrameCapacity = 32;
+    struct input_event m_frame[FrameCapacity];
+    int m_frameSize;
+};
+
+#endif // LINUXKEYBOARDDEVICE_H
@@ -0,0 +1,109 @@
+#include "linuxmotiondevice.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define GYRO_MAX_VAL 32767
+#define ACCEL_MAX_VAL 32767
+
+LinuxMotionDevice::LinuxMotionDevice(): m_fileDescriptor(-1) {
+    init();
+}
+
+LinuxMotionDevice::~LinuxMotionDevice() {
+    if(m_fileDescriptor < 0)
+        return;
+    if(ioctl(m_fileDescriptor, UI_DEV_DESTROY) < 0) {
+        printf("error: ioctl");
+    }
+    close(m_fileDescriptor);
+}
+
+bool LinuxMotionDevice::isOpen() const {
+    return m_fileDescriptor >= 0;
+}
+
+void LinuxMotionDevice::init() {
+    m_fileDescriptor = open("/dev/uinput", O_WRONLY | O_NONBLOCK); //opening of uinput
+    if (m_fileDescriptor < 0) {
+        printf("Opening of uinput failed!\n");
+        return;
+    }
+    ioctl(m_fileDescriptor, UI_SET_PROPBIT, INPUT_PROP_ACCELEROMETER); //marks this as the motion half of the pad
+    ioctl(m_fileDescriptor, UI_SET_EVBIT, EV_ABS);
+    ioctl(m_fileDescriptor, UI_SET_EVBIT, EV_MSC);
+    ioctl(m_fileDescriptor, UI_SET_MSCBIT, MSC_TIMESTAMP);
+
+    struct uinput_user_dev uidev;
+    memset(&uidev, 0, sizeof(uidev));
+    snprintf(uidev.name, UINPUT_MAX_NAME_SIZE, "Gamepad Emulator Motion Sensors");
+    uidev.id.bustype = BUS_USB;
+    uidev.id.vendor  = 0x3;
+    uidev.id.product = 0x3;
+    uidev.id.version = 2;
+    // Accelerometer, resolution is units per g
+    for(const int axis: {ABS_X, ABS_Y, ABS_Z}) {
+        ioctl(m_fileDescriptor, UI_SET_ABSBIT, axis);
+        uidev.absmax[axis] = ACCEL_MAX_VAL;
+        uidev.absmin[axis] = -ACCEL_MAX_VAL - 1;
+    }
+    // Gyroscope, resolution is units per degree per second
+    for(const int axis: {ABS_RX, ABS_RY, ABS_RZ}) {
+        ioctl(m_fileDescriptor, UI_SET_ABSBIT, axis);
+        uidev.absmax[axis] = GYRO_MAX_VAL;
+        uidev.absmin[axis] = -GYRO_MAX_VAL - 1;
+    }
+    if(write(m_fileDescriptor, &uidev, sizeof(uidev)) < 0) //writing settings
+    {
+        printf("error: write");
+    }
+
+    // uinput_user_dev has no resolution field, set it per axis before creating the device
+    struct uinput_abs_setup setup;
+    for(const int axis: {ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ}) {
+        memset(&setup, 0, sizeof(setup));
+        setup.code = axis;
+        const bool gyro = axis >= ABS_RX;
+        setup.absinfo.maximum = gyro ? GYRO_MAX_VAL : ACCEL_MAX_VAL;
+        setup.absinfo.minimum = -setup.absinfo.maximum - 1;
+        setup.absinfo.resolution = gyro ? MotionPacket::GyroPerDps : MotionPacket::AccelPerG;
+        ioctl(m_fileDescriptor, UI_ABS_SETUP, &setup);
+    }
+
+    if(ioctl(m_fileDescriptor, UI_DEV_CREATE) < 0) //writing ui dev create
+    {
+        printf("error: ui_dev_create");
+    }
+}
+
+void LinuxMotionDevice::submit(const MotionPacket &packet) {
+    if(m_fileDescriptor < 0 || packet.isEmpty())
+        return;
+
+    memset(m_events, 0, sizeof(struct input_event) * packet.m_count * EventsPerSample);
+    struct input_event *ev = m_events;
+    for(int i = 0; i < packet.m_count; ++i) {
+        const MotionPacket::Sample &sample = packet.m_samples[i];
+        const __u16 codes[6] = {ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ};
+        const int16_t values[6] = {sample.accel[0], sample.accel[1], sample.accel[2], sample.gyro[0], sample.gyro[1], sample.gyro[2]};
+        for(int axis = 0; axis < 6; ++axis, ++ev) {
+            ev->type = EV_ABS;
+            ev->code = codes[axis];
+            ev->value = values[axis];
+        }
+        // The phone's sampling time, so consumers can integrate gyro without network jitter
+        ev->type = EV_MSC;
+        ev->code = MSC_TIMESTAMP;
+        ev->value = sample.timestamp;
+        ++ev;
+        ev->type = EV_SYN;
+        ev->code = SYN_REPORT;
+        ev->value = 0;
+        ++ev;
+    }
+    if(write(m_fileDescriptor, m_events, (ev - m_events) * sizeof(struct input_event)) < 0) //writing all samples at once
+    {
+        printf("error: motion-write");
+    }
+}
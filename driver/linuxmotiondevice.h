@@ -0,0 +1,28 @@
+#ifndef LINUXMOTIONDEVICE_H
+#define LINUXMOTIONDEVICE_H
+
+#include "event/motionpacket.h"
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+// Separate uinput device for the phone's gyroscope and accelerometer, the way real pads expose motion.
+// Accel goes on ABS_X/Y/Z and gyro on ABS_RX/RY/RZ, each sample carries its MSC_TIMESTAMP
+class LinuxMotionDevice {
+public:
+    LinuxMotionDevice();
+    ~LinuxMotionDevice();
+
+    bool isOpen() const;
+    // Every sample in the packet becomes its own report, all of them go out in a single write
+    void submit(const MotionPacket &packet);
+
+private:
+    void init();
+
+    int m_fileDescriptor;
+    // 6 axes, timestamp and SYN_REPORT per sample
+    static const int EventsPerSample = 8;
+    struct input_event m_events[MotionPacket::MaxSamples * EventsPerSample];
+};
+
+#endif // LINUXMOTIONDEVICE_H
@@ -0,0 +1,155 @@
+#include "macroengine.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+MacroEngine::Macro MacroEngine::turbo(const Button &btn, const int &hz) {
+    const uint32_t half = 500000 / (hz > 0 ? hz : 1);
+    Macro macro;
+    macro.trigger = btn;
+    macro.steps = {{uint32_t(btn), half}, {0, half}};
+    macro.repeat = true;
+    return macro;
+}
+
+MacroEngine::MacroEngine(): m_buttons(0) {
+    m_fileDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(m_fileDescriptor < 0) {
+        printf("error: macro timerfd");
+    }
+}
+
+MacroEngine::~MacroEngine() {
+    if(m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+}
+
+int MacroEngine::fileDescriptor() const {
+    return m_fileDescriptor;
+}
+
+void MacroEngine::setMacros(const std::vector<Macro> &macros) {
+    m_macros.clear();
+    // Empty macros would never advance
+    for(const Macro &macro: macros) {
+        if(!macro.steps.empty())
+            m_macros.push_back(macro);
+    }
+    reset();
+}
+
+void MacroEngine::reset() {
+    m_running.clear();
+    m_buttons = 0;
+    arm();
+}
+
+bool MacroEngine::press(const Button &btn, const uint64_t &now) {
+    const int macro = findMacro(btn);
+    if(macro < 0)
+        return false;
+    for(Running &running: m_running) {
+        if(running.macro == macro) {
+            // Pressed again while playing, start over
+            running.step = 0;
+            running.deadline = now + uint64_t(m_macros[macro].steps[0].durationus) * 1000;
+            running.held = true;
+            updateButtons();
+            arm();
+            return true;
+        }
+    }
+    m_running.push_back({macro, 0, now + uint64_t(m_macros[macro].steps[0].durationus) * 1000, true});
+    updateButtons();
+    arm();
+    return true;
+}
+
+bool MacroEngine::release(const Button &btn) {
+    const int macro = findMacro(btn);
+    if(macro < 0)
+        return false;
+    for(auto it = m_running.begin(); it != m_running.end(); ++it) {
+        if(it->macro != macro)
+            continue;
+        if(m_macros[macro].repeat)
+            m_running.erase(it);
+        else
+            it->held = false;
+        break;
+    }
+    updateButtons();
+    arm();
+    return true;
+}
+
+bool MacroEngine::step(const uint64_t &now) {
+    auto due = m_running.end();
+    for(auto it = m_running.begin(); it != m_running.end(); ++it) {
+        if(it->deadline <= now && (due == m_running.end() || it->deadline < due->deadline))
+            due = it;
+    }
+    if(due == m_running.end()) {
+        arm();
+        return false;
+    }
+
+    const Macro &macro = m_macros[due->macro];
+    if(++due->step == macro.steps.size()) {
+        if(macro.repeat && due->held) {
+            due->step = 0;
+        } else {
+            m_running.erase(due);
+            updateButtons();
+            return true;
+        }
+    }
+    // Chained off the previous deadline, not now, so lateness isn't carried into the next step
+    due->deadline += uint64_t(macro.steps[due->step].durationus) * 1000;
+    updateButtons();
+    return true;
+}
+
+uint32_t MacroEngine::buttons() const {
+    return m_buttons;
+}
+
+int MacroEngine::findMacro(const Button &btn) const {
+    for(size_t i = 0; i < m_macros.size(); ++i) {
+        if(m_macros[i].trigger == btn)
+            return i;
+    }
+    return -1;
+}
+
+void MacroEngine::updateButtons() {
+    m_buttons = 0;
+    for(const Running &running: m_running)
+        m_buttons |= m_macros[running.macro].steps[running.step].buttons;
+}
+
+void MacroEngine::arm() {
+    if(m_fileDescriptor < 0)
+        return;
+    uint64_t deadline = 0;
+    for(const Running &running: m_running) {
+        if(deadline == 0 || running.deadline < deadline)
+            deadline = running.deadline;
+    }
+    // Drain a pending expiry so the fd only reads ready for the new deadline
+    uint64_t expirations;
+    while(read(m_fileDescriptor, &expirations, sizeof(expirations)) > 0) {}
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if(deadline) {
+        spec.it_value.tv_sec = deadline / 1000000000ull;
+        spec.it_value.tv_nsec = deadline % 1000000000ull;
+        // A zero it_value would disarm instead of firing at once
+        if(spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+            spec.it_value.tv_nsec = 1;
+    }
+    timerfd_settime(m_fileDescriptor, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
@@ -0,0 +1,64 @@
+#ifndef MACROENGINE_H
+#define MACROENGINE_H
+
+#include "common/common.h"
+#include <vector>
+
+// Turbo and macro playback for the driver. Runs on the input thread, woken by its own timerfd
+// armed on absolute CLOCK_MONOTONIC deadlines, so step timing doesn't drift under load.
+// The buttons a macro holds are OR'ed with live input by the driver
+class MacroEngine {
+public:
+    struct Step {
+        uint32_t buttons;     // Held during the step
+        uint32_t durationus;
+    };
+
+    struct Macro {
+        Button trigger;
+        std::vector<Step> steps;
+        // Repeating macros loop while the trigger is held and stop on release,
+        // the others always play to the end once started
+        bool repeat;
+    };
+
+    // Rapid fire of btn at hz presses per second while btn is held
+    static Macro turbo(const Button &btn, const int &hz);
+
+    MacroEngine();
+    ~MacroEngine();
+
+    // Readable when a step is due, the host loop then calls step() until it returns false
+    int fileDescriptor() const;
+
+    // Input thread only, running macros are stopped
+    void setMacros(const std::vector<Macro> &macros);
+    void reset();
+
+    // True when btn triggers a macro, the live press is swallowed then
+    bool press(const Button &btn, const uint64_t &now);
+    bool release(const Button &btn);
+
+    // Advances the earliest due macro by one step, so every step gets its own frame even when late
+    bool step(const uint64_t &now);
+    uint32_t buttons() const;
+
+private:
+    struct Running {
+        int macro;
+        size_t step;
+        uint64_t deadline;
+        bool held;
+    };
+
+    int findMacro(const Button &btn) const;
+    void updateButtons();
+    void arm();
+
+    int m_fileDescriptor;
+    std::vector<Macro> m_macros;
+    std::vector<Running> m_running;
+    uint32_t m_buttons;
+};
+
+#endif // MACROENGINE_H
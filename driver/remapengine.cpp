@@ -0,0 +1,247 @@
+#include "remapengine.h"
+#include <sstream>
+#include <cstdlib>
+
+static const char *AxisNames[Remap::AxisCount] = {"LX", "LY", "RX", "RY", "LT", "RT"};
+
+static bool parseAxis(const std::string &name, Remap::Axis &axis) {
+    for(int i = 0; i < Remap::AxisCount; ++i) {
+        if(name == AxisNames[i]) {
+            axis = Remap::Axis(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseTarget(const std::string &token, const __u16 *defaultCodes, __u16 &code) {
+    const Button btn = buttonForLabel(token);
+    if(btn != Button::COUNT) {
+        code = defaultCodes[buttonIndex(btn)];
+        return true;
+    }
+    char *end = nullptr;
+    const long value = strtol(token.c_str(), &end, 0);
+    if(token.empty() || *end || value < 0 || !RemapEngine::isMappableCode(value, defaultCodes))
+        return false;
+    code = value;
+    return true;
+}
+
+// Buttons joined by '+', '-' alone for none
+static bool parseButtons(const std::string &token, uint32_t &buttons) {
+    buttons = 0;
+    if(token == "-")
+        return true;
+    if(token.empty() || token.back() == '+')
+        return false;
+    std::istringstream members(token);
+    std::string member;
+    while(std::getline(members, member, '+')) {
+        const Button btn = buttonForLabel(member);
+        if(btn == Button::COUNT)
+            return false;
+        buttons |= btn;
+    }
+    return buttons != 0;
+}
+
+static bool parseStep(const std::string &token, MacroEngine::Step &step) {
+    const size_t colon = token.rfind(':');
+    if(colon == std::string::npos || !parseButtons(token.substr(0, colon), step.buttons))
+        return false;
+    const std::string duration = token.substr(colon + 1);
+    char *end = nullptr;
+    const long ms = strtol(duration.c_str(), &end, 10);
+    if(duration.empty() || *end || ms < 1 || ms > long(Remap::MaxMacroStepms))
+        return false;
+    step.durationus = ms * 1000;
+    return true;
+}
+
+bool RemapProfile::parse(const std::string &text, const __u16 *defaultCodes, std::string &error) {
+    buttons.clear();
+    axes.clear();
+    chords.clear();
+    macros.clear();
+
+    std::istringstream lines(text);
+    std::string line;
+    for(int number = 1; std::getline(lines, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string kind, from, to, scale;
+        if(!(words >> kind))
+            continue;
+        words >> from >> to >> scale;
+        const std::string where = "line " + std::to_string(number) + ": ";
+
+        if(kind == "button") {
+            ButtonRule rule;
+            rule.from = buttonForLabel(from);
+            if(rule.from == Button::COUNT || !parseTarget(to, defaultCodes, rule.code)) {
+                error = where + "bad button rule";
+                return false;
+            }
+            buttons.push_back(rule);
+        } else if(kind == "axis") {
+            AxisRule rule;
+            rule.scale = scale.empty() ? 1 : strtof(scale.c_str(), nullptr);
+            if(!parseAxis(from, rule.from) || !parseAxis(to, rule.to) || rule.scale == 0) {
+                error = where + "bad axis rule";
+                return false;
+            }
+            axes.push_back(rule);
+        } else if(kind == "chord") {
+            ChordRule rule = {0, 0};
+            // A single button is a plain remap, not a chord
+            if(!parseButtons(from, rule.buttons) || __builtin_popcount(rule.buttons) < 2 || !parseTarget(to, defaultCodes, rule.code) || chords.size() == size_t(Remap::MaxChords)) {
+                error = where + "bad chord rule";
+                return false;
+            }
+            chords.push_back(rule);
+        } else if(kind == "turbo") {
+            const Button btn = buttonForLabel(from);
+            char *end = nullptr;
+            const long hz = strtol(to.c_str(), &end, 10);
+            if(btn == Button::COUNT || to.empty() || *end || hz < 1 || hz > Remap::MaxTurboHz || !scale.empty()) {
+                error = where + "bad turbo rule";
+                return false;
+            }
+            if(hasMacro(btn)) {
+                error = where + "button already has a turbo or macro";
+                return false;
+            }
+            macros.push_back(MacroEngine::turbo(btn, hz));
+        } else if(kind == "macro") {
+            MacroEngine::Macro macro;
+            macro.trigger = buttonForLabel(from);
+            macro.repeat = false;
+            // Steps are the rest of the line, after the trigger
+            std::istringstream steps(line);
+            std::string step;
+            steps >> step >> step;
+            bool valid = macro.trigger != Button::COUNT;
+            while(valid && steps >> step) {
+                if(step == "repeat" && macro.steps.empty() && !macro.repeat) {
+                    macro.repeat = true;
+                    continue;
+                }
+                MacroEngine::Step parsed;
+                valid = parseStep(step, parsed);
+                macro.steps.push_back(parsed);
+            }
+            if(!valid || macro.steps.empty()) {
+                error = where + "bad macro rule";
+                return false;
+            }
+            if(hasMacro(macro.trigger)) {
+                error = where + "button already has a turbo or macro";
+                return false;
+            }
+            macros.push_back(macro);
+        } else {
+            error = where + "unknown rule " + kind;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RemapProfile::hasMacro(const Button &btn) const {
+    for(const MacroEngine::Macro &macro: macros) {
+        if(macro.trigger == btn)
+            return true;
+    }
+    return false;
+}
+
+RemapEngine::Guard::Guard(RemapEngine &engine): m_engine(engine) {
+    // Publish the hazard, then make sure the table wasn't swapped out in between
+    const CompiledRemap *remap = m_engine.m_active.load(std::memory_order_acquire);
+    const CompiledRemap *check;
+    do {
+        check = remap;
+        m_engine.m_hazard.store(remap, std::memory_order_seq_cst);
+        remap = m_engine.m_active.load(std::memory_order_seq_cst);
+    } while(remap != check);
+    m_remap = remap;
+}
+
+RemapEngine::Guard::~Guard() {
+    m_engine.m_hazard.store(nullptr, std::memory_order_release);
+}
+
+RemapEngine::RemapEngine(const __u16 *defaultCodes): m_defaultCodes(defaultCodes), m_active(nullptr), m_hazard(nullptr) {
+    m_active.store(compile(RemapProfile()));
+}
+
+RemapEngine::~RemapEngine() {
+    delete m_active.load();
+    for(const CompiledRemap *remap: m_retired)
+        delete remap;
+}
+
+void RemapEngine::setProfile(const RemapProfile &profile) {
+    publish(compile(profile));
+}
+
+void RemapEngine::resetProfile() {
+    publish(compile(RemapProfile()));
+}
+
+bool RemapEngine::isMappableCode(const __u16 &code, const __u16 *defaultCodes) {
+    if(code >= Remap::FirstKey && code <= Remap::LastKey)
+        return true;
+    for(int i = 0; i < ButtonTables::Count; ++i) {
+        if(code && defaultCodes[i] == code)
+            return true;
+    }
+    return false;
+}
+
+CompiledRemap *RemapEngine::compile(const RemapProfile &profile) const {
+    CompiledRemap *remap = new CompiledRemap;
+    for(int i = 0; i < ButtonTables::Count; ++i)
+        remap->buttonCodes[i] = m_defaultCodes[i];
+    for(int i = 0; i < Remap::AxisCount; ++i)
+        remap->axes[i] = {Remap::Axis(i), 1};
+    remap->chordCount = 0;
+    remap->chordButtons = 0;
+
+    for(const RemapProfile::ButtonRule &rule: profile.buttons) {
+        const int index = buttonIndex(rule.from);
+        if(index >= 0 && index < ButtonTables::Count && (rule.code == 0 || isMappableCode(rule.code, m_defaultCodes)))
+            remap->buttonCodes[index] = rule.code;
+    }
+    for(const RemapProfile::AxisRule &rule: profile.axes)
+        remap->axes[rule.from] = {rule.to, rule.scale};
+    for(const RemapProfile::ChordRule &rule: profile.chords) {
+        if(remap->chordCount == Remap::MaxChords || !isMappableCode(rule.code, m_defaultCodes))
+            continue;
+        remap->chords[remap->chordCount++] = {rule.buttons, rule.code};
+        remap->chordButtons |= rule.buttons;
+    }
+    return remap;
+}
+
+void RemapEngine::publish(CompiledRemap *remap) {
+    const CompiledRemap *previous = m_active.exchange(remap, std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> lock(m_retiredMutex);
+    m_retired.push_back(previous);
+    reclaim();
+}
+
+void RemapEngine::reclaim() {
+    // Anything not behind the hazard can't be picked up again, the reader only ever sees m_active
+    const CompiledRemap *hazard = m_hazard.load(std::memory_order_seq_cst);
+    auto it = m_retired.begin();
+    while(it != m_retired.end()) {
+        if(*it != hazard) {
+            delete *it;
+            it = m_retired.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef REMAPENGINE_H
+#define REMAPENGINE_H
+
+#include "common/common.h"
+#include "driver/macroengine.h"
+#include <linux/input.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Remap {
+    enum Axis {
+        LeftX,
+        LeftY,
+        RightX,
+        RightY,
+        LeftTrigger,
+        RightTrigger,
+        AxisCount,
+    };
+
+    // Keys on the virtual keyboard next to the pad, profiles can only target these or the pad's own buttons
+    static const __u16 FirstKey = KEY_ESC;
+    static const __u16 LastKey = KEY_F12;
+    static const int MaxChords = 16;
+    static const int MaxTurboHz = 50;
+    static const uint32_t MaxMacroStepms = 10000;
+}
+
+// Editable description of a mapping, RemapEngine compiles it into flat tables
+struct RemapProfile {
+    struct ButtonRule {
+        Button from;
+        __u16 code; // evdev key or button code, 0 disables the button
+    };
+    struct AxisRule {
+        Remap::Axis from;
+        Remap::Axis to;
+        float scale; // Negative inverts
+    };
+    struct ChordRule {
+        uint32_t buttons; // Fires once all of these are held
+        __u16 code;
+    };
+
+    std::vector<ButtonRule> buttons;
+    std::vector<AxisRule> axes;
+    std::vector<ChordRule> chords;
+    // Not part of the compiled table, they go to the driver's MacroEngine
+    std::vector<MacroEngine::Macro> macros;
+
+    // One rule per line, '#' starts a comment:
+    //   button <LABEL> <LABEL|code>
+    //   axis <LX|LY|RX|RY|LT|RT> <LX|LY|RX|RY|LT|RT> [scale]
+    //   chord <LABEL>+<LABEL>... <LABEL|code>
+    //   turbo <LABEL> <hz>
+    //   macro <LABEL> [repeat] <LABEL>+<LABEL>...:<ms> ...
+    // Labels are the BUTTONS_DEFINITIONS names, a label as target means that button's default code.
+    // A macro step holds its buttons for ms, '-' holds none, e.g. "macro Y A:40 -:20 B+X:40
+    bool parse(const std::string &text, const __u16 *defaultCodes, std::string &error);
+    bool hasMacro(const Button &btn) const;
+};
+
+// Profile flattened for the input thread, one array lookup per button or axis
+struct CompiledRemap {
+    struct AxisTarget {
+        Remap::Axis to;
+        float scale;
+    };
+    struct Chord {
+        uint32_t buttons;
+        __u16 code;
+    };
+
+    __u16 buttonCodes[ButtonTables::Count];
+    AxisTarget axes[Remap::AxisCount];
+    Chord chords[Remap::MaxChords];
+    int chordCount;
+    // Union of all chord buttons, presses outside it skip the chord scan
+    uint32_t chordButtons;
+
+    inline __u16 buttonCode(const Button &btn) const {
+        const int index = buttonIndex(btn);
+        return index < 0 || index >= ButtonTables::Count ? 0 : buttonCodes[index];
+    }
+};
+
+// Holds the active CompiledRemap. The input thread reads it under a single hazard pointer,
+// setProfile swaps in a new table with one atomic exchange and frees old ones once unused
+class RemapEngine {
+public:
+    // Pins the active table for the input thread, only one Guard may exist at a time
+    class Guard {
+    public:
+        explicit Guard(RemapEngine &engine);
+        ~Guard();
+        const CompiledRemap *operator->() const { return m_remap; }
+        const CompiledRemap &operator*() const { return *m_remap; }
+
+    private:
+        RemapEngine &m_engine;
+        const CompiledRemap *m_remap;
+    };
+
+    // defaultCodes is the identity mapping, indexed by button bit position
+    explicit RemapEngine(const __u16 *defaultCodes);
+    ~RemapEngine();
+
+    // Callable from any thread, never blocks the reader
+    void setProfile(const RemapProfile &profile);
+    void resetProfile();
+
+    static bool isMappableCode(const __u16 &code, const __u16 *defaultCodes);
+
+private:
+    CompiledRemap *compile(const RemapProfile &profile) const;
+    void publish(CompiledRemap *remap);
+    void reclaim();
+
+    const __u16 *m_defaultCodes;
+    std::atomic<const CompiledRemap*> m_active;
+    std::atomic<const CompiledRemap*> m_hazard;
+    // Writer side only
+    std::mutex m_retiredMutex;
+    std::vector<const CompiledRemap*> m_retired;
+};
+
+#endif // REMAPENGINE_H
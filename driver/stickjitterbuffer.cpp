@@ -0,0 +1,142 @@
+#include "stickjitterbuffer.h"
+#include <cstdlib>
+
+StickJitterBuffer::StickJitterBuffer(): m_minDelayus(1000), m_maxDelayus(20000) {
+    reset();
+}
+
+void StickJitterBuffer::push(const Frame &frame, const uint32_t &arrival) {
+    // Interarrival jitter estimator from RFC 3550, the delay target follows it smoothly
+    const uint32_t transit = arrival - frame.timestamp;
+    if(!m_hasTransit) {
+        m_baseTransit = transit;
+        m_lastTransit = transit;
+        m_hasTransit = true;
+    } else {
+        const int32_t d = timestampDelta(transit, m_lastTransit);
+        m_jitter += (std::abs(d) - m_jitter) / 16.f;
+        m_lastTransit = transit;
+        // Creep up by 1us per frame so the base follows clock drift between the two devices
+        if(timestampDelta(transit, m_baseTransit) < 0)
+            m_baseTransit = transit;
+        else
+            m_baseTransit += 1;
+    }
+    float target = 3.f * m_jitter;
+    if(target < m_minDelayus)
+        target = m_minDelayus;
+    if(target > m_maxDelayus)
+        target = m_maxDelayus;
+    m_delay += (target - m_delay) / 8.f;
+
+    Queue &q = queue(frame.stick);
+    if(q.played && timestampDelta(frame.timestamp, q.lastPlayed) <= 0) {
+        ++m_droppedFrames;
+        return;
+    }
+    if(timestampDelta(arrival, playoutTime(frame)) > 0)
+        ++m_lateFrames;
+    if(q.size == Capacity) {
+        q.head = (q.head + 1) % Capacity;
+        --q.size;
+        ++m_droppedFrames;
+    }
+
+    // Frames mostly arrive in order, so insertion from the back is cheap
+    int i = q.size;
+    while(i > 0) {
+        const Frame &previous = q.frames[(q.head + i - 1) % Capacity];
+        if(timestampDelta(previous.timestamp, frame.timestamp) <= 0)
+            break;
+        q.frames[(q.head + i) % Capacity] = previous;
+        --i;
+    }
+    q.frames[(q.head + i) % Capacity] = frame;
+    ++q.size;
+}
+
+bool StickJitterBuffer::pop(const uint32_t &now, Frame &frame) {
+    for(Queue &q: m_queues) {
+        if(q.size == 0 || timestampDelta(now, playoutTime(q.frames[q.head])) < 0)
+            continue;
+        while(q.size > 1 && timestampDelta(now, playoutTime(q.frames[(q.head + 1) % Capacity])) >= 0) {
+            q.head = (q.head + 1) % Capacity;
+            --q.size;
+        }
+        frame = q.frames[q.head];
+        q.head = (q.head + 1) % Capacity;
+        --q.size;
+        q.played = true;
+        q.lastPlayed = frame.timestamp;
+        return true;
+    }
+    return false;
+}
+
+bool StickJitterBuffer::nextDeadline(uint32_t &deadline) const {
+    bool found = false;
+    for(const Queue &q: m_queues) {
+        if(q.size == 0)
+            continue;
+        const uint32_t playout = playoutTime(q.frames[q.head]);
+        if(!found || timestampDelta(playout, deadline) < 0)
+            deadline = playout;
+        found = true;
+    }
+    return found;
+}
+
+void StickJitterBuffer::clear(const Button &stick) {
+    Queue &q = queue(stick);
+    if(q.size > 0) {
+        q.played = true;
+        q.lastPlayed = q.frames[(q.head + q.size - 1) % Capacity].timestamp;
+    }
+    q.head = 0;
+    q.size = 0;
+}
+
+void StickJitterBuffer::reset() {
+    for(Queue &q: m_queues) {
+        q.head = 0;
+        q.size = 0;
+        q.played = false;
+        q.lastPlayed = 0;
+    }
+    m_hasTransit = false;
+    m_baseTransit = 0;
+    m_lastTransit = 0;
+    m_jitter = 0;
+    m_delay = m_minDelayus;
+    m_lateFrames = 0;
+    m_droppedFrames = 0;
+}
+
+void StickJitterBuffer::setDelayLimits(const uint32_t &minDelayus, const uint32_t &maxDelayus) {
+    m_minDelayus = minDelayus;
+    m_maxDelayus = maxDelayus < minDelayus ? minDelayus : maxDelayus;
+}
+
+uint32_t StickJitterBuffer::delay() const {
+    return uint32_t(m_delay);
+}
+
+float StickJitterBuffer::jitter() const {
+    return m_jitter;
+}
+
+uint32_t StickJitterBuffer::lateFrames() const {
+    return m_lateFrames;
+}
+
+uint32_t StickJitterBuffer::droppedFrames() const {
+    return m_droppedFrames;
+}
+
+StickJitterBuffer::Queue &StickJitterBuffer::queue(const Button &stick) {
+    return m_queues[stick == Button::LEFTSTICK ? 0 : 1];
+}
+
+uint32_t StickJitterBuffer::playoutTime(const Frame &frame) const {
+    return frame.timestamp + m_baseTransit + uint32_t(m_delay);
+}
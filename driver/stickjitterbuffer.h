@@ -0,0 +1,62 @@
+#ifndef STICKJITTERBUFFER_H
+#define STICKJITTERBUFFER_H
+
+#include "common/common.h"
+#include <cstdint>
+
+// Playout buffer for stick frames. Frames are released at their send timestamp plus the
+// lowest observed transit time plus a delay that follows the measured interarrival jitter
+class StickJitterBuffer {
+public:
+    struct Frame {
+        Button stick;
+        float x;
+        float y;
+        uint32_t timestamp; // Sender clock in microseconds
+    };
+
+    StickJitterBuffer();
+
+    // arrival and now are local monotonicMicros()
+    void push(const Frame &frame, const uint32_t &arrival);
+    // Pops the newest due frame of a stick, older due frames of the same stick are superseded
+    bool pop(const uint32_t &now, Frame &frame);
+    bool nextDeadline(uint32_t &deadline) const;
+    void clear(const Button &stick);
+    void reset();
+
+    void setDelayLimits(const uint32_t &minDelayus, const uint32_t &maxDelayus);
+    uint32_t delay() const;
+    float jitter() const;
+    uint32_t lateFrames() const;
+    uint32_t droppedFrames() const;
+
+private:
+    static const int StickCount = 2;
+    static const int Capacity = 32;
+
+    struct Queue {
+        Frame frames[Capacity];
+        int head;
+        int size;
+        bool played;
+        uint32_t lastPlayed;
+    };
+
+    Queue &queue(const Button &stick);
+    uint32_t playoutTime(const Frame &frame) const;
+
+    Queue m_queues[StickCount];
+    // Transit is arrival minus send time, the offset between the two clocks included
+    bool m_hasTransit;
+    uint32_t m_baseTransit;
+    uint32_t m_lastTransit;
+    float m_jitter;
+    float m_delay;
+    uint32_t m_minDelayus;
+    uint32_t m_maxDelayus;
+    uint32_t m_lateFrames;
+    uint32_t m_droppedFrames;
+};
+
+#endif // STICKJITTERBUFFER_H
@@ -0,0 +1,147 @@
+#include "stickpredictor.h"
+#include <cmath>
+
+StickPredictor::StickPredictor(): m_maxGapus(100000), m_maxCorrection(0.15f), m_heartbeatTimeoutus(1000000) {
+    reset();
+}
+
+void StickPredictor::heartbeat(const uint32_t &now) {
+    m_lastHeartbeat = now;
+    m_hasHeartbeat = true;
+}
+
+bool StickPredictor::heartbeatExpired(const uint32_t &now) const {
+    return m_hasHeartbeat && timestampDelta(now, m_lastHeartbeat) > int32_t(m_heartbeatTimeoutus);
+}
+
+void StickPredictor::press(const Button &stick, const float &x, const float &y, const uint32_t &now) {
+    State &s = state(stick);
+    s.active = true;
+    s.corrected = false;
+    s.x = s.outX = x;
+    s.y = s.outY = y;
+    s.vx = s.vy = 0;
+    s.time = now;
+    s.interval = 0;
+}
+
+void StickPredictor::update(const Button &stick, const float &x, const float &y, const uint32_t &now, float &outX, float &outY) {
+    State &s = state(stick);
+    if(!s.active) {
+        press(stick, x, y, now);
+        outX = x;
+        outY = y;
+        return;
+    }
+
+    const int32_t dt = timestampDelta(now, s.time);
+    if(dt > 0 && uint32_t(dt) < m_maxGapus) {
+        s.vx += ((x - s.x) / dt - s.vx) * 0.5f;
+        s.vy += ((y - s.y) / dt - s.vy) * 0.5f;
+        s.interval = s.interval > 0 ? s.interval + (dt - s.interval) / 8.f : dt;
+    } else {
+        s.vx = s.vy = 0;
+    }
+    s.x = x;
+    s.y = y;
+    s.time = now;
+
+    if(s.corrected) {
+        // Converge from the predicted position in steps of at most m_maxCorrection
+        const float ex = x - s.outX;
+        const float ey = y - s.outY;
+        const float error = std::sqrt(ex * ex + ey * ey);
+        if(error > m_maxCorrection) {
+            s.outX += ex * m_maxCorrection / error;
+            s.outY += ey * m_maxCorrection / error;
+        } else {
+            s.corrected = false;
+        }
+    }
+    if(!s.corrected) {
+        s.outX = x;
+        s.outY = y;
+    }
+    outX = s.outX;
+    outY = s.outY;
+}
+
+bool StickPredictor::extrapolate(const Button &stick, const uint32_t &now, float &outX, float &outY) {
+    State &s = state(stick);
+    if(!s.active || s.interval <= 0)
+        return false;
+
+    // Nothing to hide while the next packet is still due
+    const int32_t gap = timestampDelta(now, s.time);
+    if(gap < 1.5f * s.interval)
+        return false;
+    float x, y;
+    if(gap < int32_t(m_maxGapus)) {
+        x = s.x + s.vx * gap;
+        y = s.y + s.vy * gap;
+        const float length = std::sqrt(x * x + y * y);
+        if(length > 1) {
+            x /= length;
+            y /= length;
+        }
+    } else {
+        // Past the horizon the velocity is stale, walk back to the last real sample
+        const float ex = s.x - s.outX;
+        const float ey = s.y - s.outY;
+        const float error = std::sqrt(ex * ex + ey * ey);
+        x = error > m_maxCorrection ? s.outX + ex * m_maxCorrection / error : s.x;
+        y = error > m_maxCorrection ? s.outY + ey * m_maxCorrection / error : s.y;
+    }
+    if(x == s.outX && y == s.outY)
+        return false;
+
+    s.outX = outX = x;
+    s.outY = outY = y;
+    s.corrected = x != s.x || y != s.y;
+    return true;
+}
+
+void StickPredictor::release(const Button &stick) {
+    State &s = state(stick);
+    s.active = false;
+    s.corrected = false;
+    s.x = s.y = s.outX = s.outY = 0;
+    s.vx = s.vy = 0;
+}
+
+bool StickPredictor::active(const Button &stick) const {
+    return state(stick).active;
+}
+
+void StickPredictor::reset() {
+    for(State &s: m_states) {
+        s.active = false;
+        s.corrected = false;
+        s.x = s.y = s.outX = s.outY = 0;
+        s.vx = s.vy = 0;
+        s.time = 0;
+        s.interval = 0;
+    }
+    m_lastHeartbeat = 0;
+    m_hasHeartbeat = false;
+}
+
+void StickPredictor::setMaxGap(const uint32_t &maxGapus) {
+    m_maxGapus = maxGapus;
+}
+
+void StickPredictor::setMaxCorrection(const float &maxCorrection) {
+    m_maxCorrection = maxCorrection;
+}
+
+void StickPredictor::setHeartbeatTimeout(const uint32_t &timeoutus) {
+    m_heartbeatTimeoutus = timeoutus;
+}
+
+StickPredictor::State &StickPredictor::state(const Button &stick) {
+    return m_states[stick == Button::LEFTSTICK ? 0 : 1];
+}
+
+const StickPredictor::State &StickPredictor::state(const Button &stick) const {
+    return m_states[stick == Button::LEFTSTICK ? 0 : 1];
+}
@@ -0,0 +1,57 @@
+#ifndef STICKPREDICTOR_H
+#define STICKPREDICTOR_H
+
+#include "common/common.h"
+#include <cstdint>
+
+// Extrapolates stick positions from their recent velocity while packets are late or lost.
+// On-time data passes through untouched, after a gap the output walks back to the real
+// position in bounded steps instead of jumping. Gaps beyond the max gap walk back the same way
+class StickPredictor {
+public:
+    StickPredictor();
+
+    // Any datagram from the controller, control messages and dummy keepalives included
+    void heartbeat(const uint32_t &now);
+    bool heartbeatExpired(const uint32_t &now) const;
+
+    void press(const Button &stick, const float &x, const float &y, const uint32_t &now);
+    void update(const Button &stick, const float &x, const float &y, const uint32_t &now, float &outX, float &outY);
+    // Returns true when a new predicted position was written to outX and outY
+    bool extrapolate(const Button &stick, const uint32_t &now, float &outX, float &outY);
+    void release(const Button &stick);
+    bool active(const Button &stick) const;
+    void reset();
+
+    void setMaxGap(const uint32_t &maxGapus);
+    void setMaxCorrection(const float &maxCorrection);
+    void setHeartbeatTimeout(const uint32_t &timeoutus);
+
+private:
+    static const int StickCount = 2;
+
+    struct State {
+        bool active;
+        bool corrected; // Output differs from the last real sample
+        float x;
+        float y;
+        float vx; // Units per microsecond
+        float vy;
+        float outX;
+        float outY;
+        uint32_t time;
+        float interval; // Smoothed packet interval in microseconds
+    };
+
+    State &state(const Button &stick);
+    const State &state(const Button &stick) const;
+
+    State m_states[StickCount];
+    uint32_t m_lastHeartbeat;
+    bool m_hasHeartbeat;
+    uint32_t m_maxGapus;
+    float m_maxCorrection;
+    uint32_t m_heartbeatTimeoutus;
+};
+
+#endif // STICKPREDICTOR_H
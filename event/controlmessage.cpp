@@ -0,0 +1,47 @@
+#include "controlmessage.h"
+
+static const size_t EntrySize = 5;
+
+ControlMessage::ControlMessage(const Opcode &opcode): m_opcode(opcode) {
+
+}
+
+ControlMessage::ControlMessage(const std::vector<uint8_t> &data): m_opcode(Quit) {
+    if(!isControl(data))
+        return;
+    m_opcode = Opcode(data[0]);
+    m_payload.assign(data.begin() + 1, data.end());
+}
+
+std::vector<uint8_t> ControlMessage::data() const {
+    std::vector<uint8_t> dt;
+    dt.reserve(1 + m_payload.size());
+    dt.push_back(m_opcode);
+    dt.insert(dt.end(), m_payload.begin(), m_payload.end());
+    return dt;
+}
+
+void ControlMessage::setValue(const uint8_t &key, const uint32_t &value) {
+    for(size_t i = 0; i + EntrySize <= m_payload.size(); i += EntrySize) {
+        if(m_payload[i] == key) {
+            m_payload.erase(m_payload.begin() + i, m_payload.begin() + i + EntrySize);
+            break;
+        }
+    }
+    m_payload.push_back(key);
+    m_payload.push_back(value >> 24);
+    m_payload.push_back(value >> 16 & 0xff);
+    m_payload.push_back(value >> 8 & 0xff);
+    m_payload.push_back(value & 0xff);
+}
+
+bool ControlMessage::value(const uint8_t &key, uint32_t &value) const {
+    for(size_t i = 0; i + EntrySize <= m_payload.size(); i += EntrySize) {
+        if(m_payload[i] != key)
+            continue;
+        const uint8_t *p = &m_payload[i + 1];
+        value = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+#ifndef CONTROLMESSAGE_H
+#define CONTROLMESSAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Session control, kept apart from input by the first byte: opcodes have the high bit set and input
+// frames never do, so transceivers route on one bit test without parsing either kind.
+// Config, Capabilities, Ping and Pong carry (key, value) pairs, one key byte and a big endian u32 each
+struct ControlMessage {
+    static const uint8_t ControlBit = 0x80;
+
+    enum Opcode : uint8_t {
+        Quit = 0x80,
+        Config = 0x81,
+        // Payload is RumbleEvent's, see rumbleevent.h
+        Rumble = 0x82,
+        Capabilities = 0x83,
+        // Round trip probe, the peer sends the payload back as a Pong with EchoTime added
+        Ping = 0x84,
+        Pong = 0x85,
+    };
+
+    // Config and Capabilities keys, unknown ones are skipped so either side can add more
+    enum Key : uint8_t {
+        JitterBuffer = 1,
+        StickPrediction = 2,
+        CodecVersion = 16,
+        TickRate = 17,
+        AxisBits = 18,
+        Redundancy = 19,
+        Channels = 20,
+        Sequence = 32,
+        SenderTime = 33,
+        EchoTime = 34,
+    };
+
+    ControlMessage(const Opcode &opcode = Quit);
+    ControlMessage(const std::vector<uint8_t> &data);
+    std::vector<uint8_t> data() const;
+
+    static inline bool isControl(const std::vector<uint8_t> &data) {
+        return !data.empty() && (data[0] & ControlBit);
+    }
+
+    void setValue(const uint8_t &key, const uint32_t &value);
+    // False when the message doesn't carry the key
+    bool value(const uint8_t &key, uint32_t &value) const;
+
+    Opcode m_opcode;
+    std::vector<uint8_t> m_payload;
+};
+
+#endif // CONTROLMESSAGE_H
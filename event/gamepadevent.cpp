@@ -1,28 +1,140 @@
 #include "gamepadevent.h"
-#include <QDataStream>
+#include "common/trace.h"
+#include <cstring>
+#include <cmath>
 
-GamepadEvent::GamepadEvent(const Type &type, const Button &btn, const QPointF &value): m_type(type), m_button(btn), m_value(value) {
+namespace {
+// Reads past the end yield zero, as QDataStream did on short datagrams
+class Reader {
+public:
+    Reader(const std::vector<uint8_t> &data): m_data(data), m_position(0) {}
+
+    uint64_t read(const int &bytes) {
+        uint64_t value = 0;
+        for(int i = 0; i < bytes; ++i)
+            value = value << 8 | (m_position < m_data.size() ? m_data[m_position++] : 0);
+        return value;
+    }
+
+    double readDouble() {
+        const uint64_t bits = read(8);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+private:
+    const std::vector<uint8_t> &m_data;
+    size_t m_position;
+};
+
+void write(std::vector<uint8_t> &data, const uint64_t &value, const int &bytes) {
+    for(int i = bytes - 1; i >= 0; --i)
+        data.push_back(uint8_t(value >> (i * 8)));
+}
+
+int16_t compactAxis(const double &value) {
+    const double clamped = value < -1 ? -1 : (value > 1 ? 1 : value);
+    return int16_t(lround(clamped * GamepadEvent::CompactAxisMax));
+}
+
+void writeDouble(std::vector<uint8_t> &data, const double &value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write(data, bits, 8);
+}
+}
+
+GamepadEvent::GamepadEvent(const Type &type, const Button &btn, const PointF &value): m_type(type), m_button(btn), m_value(value), m_timestamp(monotonicMicros()), m_trigger(0) {
 
 }
 
-GamepadEvent::GamepadEvent(const QByteArray &data) {
-    QByteArray dt = data;
-    QDataStream in(&dt, QIODevice::ReadOnly);
+GamepadEvent::GamepadEvent(const Type &type, const Button &btn, const uint16_t &trigger): m_type(type), m_button(btn), m_timestamp(0), m_trigger(trigger < TriggerMax ? trigger : TriggerMax) {
 
-    in >> m_type;
-    in >> m_button;
-    if(m_type != GamepadEvent::ButtonPressEvent && m_type != GamepadEvent::ButtonReleaseEvent)
-        in >> m_value;
 }
 
-QByteArray GamepadEvent::data() const {
-    QByteArray dt;
-    QDataStream out(&dt, QIODevice::WriteOnly);
+GamepadEvent::GamepadEvent(const std::vector<uint8_t> &data): m_timestamp(0), m_trigger(0) {
+    TRACE_SCOPE("decode gamepad");
+    Reader in(data);
+
+    if(!data.empty() && data[0] == CompactTag) {
+        in.read(1);
+        m_type = Type(in.read(1));
+        const uint8_t bit = in.read(1);
+        m_button = Button(bit < 32 ? 1u << bit : 0);
+        if(m_type == GamepadEvent::TriggerMoveEvent) {
+            m_trigger = in.read(2);
+            if(m_trigger > TriggerMax)
+                m_trigger = TriggerMax;
+        } else if(m_type != GamepadEvent::ButtonPressEvent && m_type != GamepadEvent::ButtonReleaseEvent) {
+            const double x = int16_t(in.read(2)) / double(CompactAxisMax);
+            const double y = int16_t(in.read(2)) / double(CompactAxisMax);
+            m_value = PointF(x, y);
+            m_timestamp = in.read(4);
+        }
+        return;
+    }
+
+    m_type = Type(int32_t(in.read(4)));
+    m_button = Button(int32_t(in.read(4)));
+    if(m_type == GamepadEvent::TriggerMoveEvent) {
+        m_trigger = in.read(2);
+        if(m_trigger > TriggerMax)
+            m_trigger = TriggerMax;
+    } else if(m_type != GamepadEvent::ButtonPressEvent && m_type != GamepadEvent::ButtonReleaseEvent) {
+        const double x = in.readDouble();
+        const double y = in.readDouble();
+        m_value = PointF(x, y);
+        m_timestamp = in.read(4);
+    }
+}
 
-    out << m_type;
-    out << m_button;
-    if(m_type != GamepadEvent::ButtonPressEvent && m_type != GamepadEvent::ButtonReleaseEvent)
-        out << m_value;
+std::vector<uint8_t> GamepadEvent::data(const bool &compact) const {
+    TRACE_SCOPE("encode gamepad");
+    std::vector<uint8_t> dt;
+    dt.reserve(compact ? 11 : 28);
+
+    if(compact) {
+        dt.push_back(uint8_t(CompactTag));
+        dt.push_back(uint8_t(m_type));
+        dt.push_back(m_button ? uint8_t(__builtin_ctz(uint32_t(m_button))) : 0xff);
+        if(m_type == GamepadEvent::TriggerMoveEvent) {
+            write(dt, m_trigger, 2);
+        } else if(m_type != GamepadEvent::ButtonPressEvent && m_type != GamepadEvent::ButtonReleaseEvent) {
+            write(dt, uint16_t(compactAxis(m_value.x())), 2);
+            write(dt, uint16_t(compactAxis(m_value.y())), 2);
+            write(dt, m_timestamp, 4);
+        }
+        return dt;
+    }
+
+    write(dt, uint32_t(m_type), 4);
+    write(dt, uint32_t(m_button), 4);
+    if(m_type == GamepadEvent::TriggerMoveEvent) {
+        write(dt, m_trigger, 2);
+    } else if(m_type != GamepadEvent::ButtonPressEvent && m_type != GamepadEvent::ButtonReleaseEvent) {
+        writeDouble(dt, m_value.x());
+        writeDouble(dt, m_value.y());
+        write(dt, m_timestamp, 4);
+    }
 
     return dt;
 }
+
+bool GamepadEvent::isGamepadEvent(const std::vector<uint8_t> &data) {
+    if(data.empty())
+        return false;
+    const bool compact = data[0] == CompactTag;
+    const size_t header = compact ? 3 : 8;
+    if(data.size() < header)
+        return false;
+    const uint32_t type = compact ? data[1] : uint32_t(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+    if(type > TriggerMoveEvent)
+        return false;
+    size_t size = header;
+    if(type == TriggerMoveEvent)
+        size += 2;
+    else if(type != ButtonPressEvent && type != ButtonReleaseEvent)
+        size += compact ? 8 : 20;
+    return data.size() == size;
+}
@@ -1,10 +1,13 @@
 #ifndef GAMEPADEVENT_H
 #define GAMEPADEVENT_H
 
-//#include <QByteArray>
-//#include <QPointF>
 #include "common/common.h"
+#include <vector>
 
+// Wire layout is what QDataStream produced before, big endian: type and button as int32,
+// then for stick events x and y as float64 plus a uint32 timestamp, for triggers a uint16.
+// Sessions that negotiated the compact codec use CompactTag, type, button bit index, then
+// int16 x and y plus the timestamp, or the uint16 trigger. Decoding accepts either
 struct GamepadEvent {
     enum Type {
         DummyEvent,
@@ -13,15 +16,29 @@ struct GamepadEvent {
         StickMoveEvent,
         StickPressEvent,
         StickReleaseEvent,
+        TriggerMoveEvent,
     };
 
-    GamepadEvent(const Type &type, const Button &btn, const QPointF &value = QPointF());
-    GamepadEvent(const QByteArray &data);
-    QByteArray data() const;
+    // Triggers travel 10 bits on the wire instead of a point
+    static const uint16_t TriggerMax = 1023;
+    // Can't start the float layout, whose first byte is the high byte of the type, nor a control message
+    static const uint8_t CompactTag = 0x20;
+    static const int16_t CompactAxisMax = 32767;
+
+    GamepadEvent(const Type &type, const Button &btn, const PointF &value = PointF());
+    GamepadEvent(const Type &type, const Button &btn, const uint16_t &trigger);
+    GamepadEvent(const std::vector<uint8_t> &data);
+    std::vector<uint8_t> data(const bool &compact = false) const;
+
+    // Known type and exactly the size its layout takes, in either codec
+    static bool isGamepadEvent(const std::vector<uint8_t> &data);
 
     Type m_type;
     Button m_button;
-    QPointF m_value;
+    PointF m_value;
+    // Sender's monotonicMicros() at construction, only carried by stick events
+    uint32_t m_timestamp;
+    uint16_t m_trigger;
 };
 
 
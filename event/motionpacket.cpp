@@ -0,0 +1,88 @@
+#include "motionpacket.h"
+#include "common/trace.h"
+#include <cmath>
+
+static inline uint16_t readU16(const uint8_t *p) {
+    return uint16_t(p[0] << 8 | p[1]);
+}
+
+static inline void writeU16(uint8_t *p, const uint16_t &value) {
+    p[0] = value >> 8;
+    p[1] = value & 0xff;
+}
+
+MotionPacket::MotionPacket(): m_count(0) {
+
+}
+
+MotionPacket::MotionPacket(const std::vector<uint8_t> &data): m_count(0) {
+    TRACE_SCOPE("decode motion");
+    if(!isMotion(data))
+        return;
+    m_count = data[1];
+    uint32_t timestamp = uint32_t(data[2]) << 24 | uint32_t(data[3]) << 16 | uint32_t(data[4]) << 8 | data[5];
+    const uint8_t *p = &data[HeaderSize];
+    for(int i = 0; i < m_count; ++i, p += SampleSize) {
+        Sample &sample = m_samples[i];
+        timestamp += readU16(p);
+        sample.timestamp = timestamp;
+        for(int axis = 0; axis < 3; ++axis) {
+            sample.gyro[axis] = int16_t(readU16(p + 2 + axis * 2));
+            sample.accel[axis] = int16_t(readU16(p + 8 + axis * 2));
+        }
+    }
+}
+
+std::vector<uint8_t> MotionPacket::data() const {
+    TRACE_SCOPE("encode motion");
+    std::vector<uint8_t> dt(HeaderSize + m_count * SampleSize);
+    dt[0] = Tag;
+    dt[1] = m_count;
+    const uint32_t base = m_count ? m_samples[0].timestamp : 0;
+    dt[2] = base >> 24;
+    dt[3] = base >> 16;
+    dt[4] = base >> 8;
+    dt[5] = base;
+    uint8_t *p = &dt[HeaderSize];
+    uint32_t previous = base;
+    for(int i = 0; i < m_count; ++i, p += SampleSize) {
+        const Sample &sample = m_samples[i];
+        writeU16(p, sample.timestamp - previous);
+        previous = sample.timestamp;
+        for(int axis = 0; axis < 3; ++axis) {
+            writeU16(p + 2 + axis * 2, uint16_t(sample.gyro[axis]));
+            writeU16(p + 8 + axis * 2, uint16_t(sample.accel[axis]));
+        }
+    }
+    return dt;
+}
+
+bool MotionPacket::isMotion(const std::vector<uint8_t> &data) {
+    return data.size() >= HeaderSize && data[0] == Tag && data[1] <= MaxSamples && data.size() == HeaderSize + data[1] * SampleSize;
+}
+
+int16_t MotionPacket::quantize(const float &value, const int &scale) {
+    const float scaled = std::round(value * scale);
+    return scaled > 32767 ? 32767 : scaled < -32768 ? -32768 : int16_t(scaled);
+}
+
+bool MotionPacket::append(const Sample &sample) {
+    if(isFull())
+        return false;
+    if(m_count > 0 && uint32_t(sample.timestamp - m_samples[m_count - 1].timestamp) > 0xffff)
+        return false;
+    m_samples[m_count++] = sample;
+    return true;
+}
+
+void MotionPacket::clear() {
+    m_count = 0;
+}
+
+bool MotionPacket::isEmpty() const {
+    return m_count == 0;
+}
+
+bool MotionPacket::isFull() const {
+    return m_count == MaxSamples;
+}
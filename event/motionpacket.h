@@ -0,0 +1,44 @@
+#ifndef MOTIONPACKET_H
+#define MOTIONPACKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Several gyroscope + accelerometer samples sent in one datagram.
+// Header: tag, sample count, first sample's monotonicMicros(). Each sample then takes 14 bytes:
+// µs since the previous sample followed by gyro and accel xyz as int16 fixed point, big endian.
+// Motion is input, the tag leaves ControlMessage::ControlBit clear and can't start a GamepadEvent either
+struct MotionPacket {
+    static const uint8_t Tag = 0x40;
+    static const int MaxSamples = 16;
+    static const size_t HeaderSize = 6;
+    static const size_t SampleSize = 14;
+    // Fixed point scales, ±2048 °/s and ±8 g fit an int16
+    static const int GyroPerDps = 16;
+    static const int AccelPerG = 4096;
+
+    struct Sample {
+        uint32_t timestamp;
+        int16_t gyro[3];
+        int16_t accel[3];
+    };
+
+    MotionPacket();
+    MotionPacket(const std::vector<uint8_t> &data);
+    std::vector<uint8_t> data() const;
+
+    static bool isMotion(const std::vector<uint8_t> &data);
+    static int16_t quantize(const float &value, const int &scale);
+
+    // False when the packet is full or the gap to the previous sample doesn't fit the delta
+    bool append(const Sample &sample);
+    void clear();
+    bool isEmpty() const;
+    bool isFull() const;
+
+    Sample m_samples[MaxSamples];
+    int m_count;
+};
+
+#endif // MOTIONPACKET_H
@@ -0,0 +1,39 @@
+#include "rumbleevent.h"
+
+static inline uint16_t readU16(const uint8_t *p) {
+    return uint16_t(p[0] << 8 | p[1]);
+}
+
+static inline void writeU16(uint8_t *p, const uint16_t &value) {
+    p[0] = value >> 8;
+    p[1] = value & 0xff;
+}
+
+RumbleEvent::RumbleEvent(const uint16_t &strong, const uint16_t &weak, const uint16_t &durationms): m_strong(strong), m_weak(weak), m_durationms(durationms) {
+
+}
+
+RumbleEvent::RumbleEvent(const std::vector<uint8_t> &data): m_strong(0), m_weak(0), m_durationms(0) {
+    if(!isRumble(data))
+        return;
+    m_strong = readU16(&data[1]);
+    m_weak = readU16(&data[3]);
+    m_durationms = readU16(&data[5]);
+}
+
+std::vector<uint8_t> RumbleEvent::data() const {
+    std::vector<uint8_t> dt(Size);
+    dt[0] = Tag;
+    writeU16(&dt[1], m_strong);
+    writeU16(&dt[3], m_weak);
+    writeU16(&dt[5], m_durationms);
+    return dt;
+}
+
+bool RumbleEvent::isRumble(const std::vector<uint8_t> &data) {
+    return data.size() == Size && data[0] == Tag;
+}
+
+bool RumbleEvent::isStop() const {
+    return m_strong == 0 && m_weak == 0;
+}
@@ -0,0 +1,29 @@
+#ifndef RUMBLEEVENT_H
+#define RUMBLEEVENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "event/controlmessage.h"
+
+// Force feedback travelling back from the driver to the controller.
+// Seven bytes on the wire: the Rumble control opcode, strong and weak magnitude, duration in ms, big endian
+struct RumbleEvent {
+    static const uint8_t Tag = ControlMessage::Rumble;
+    static const size_t Size = 7;
+
+    RumbleEvent(const uint16_t &strong = 0, const uint16_t &weak = 0, const uint16_t &durationms = 0);
+    RumbleEvent(const std::vector<uint8_t> &data);
+    std::vector<uint8_t> data() const;
+
+    static bool isRumble(const std::vector<uint8_t> &data);
+    // Zero magnitudes stop whatever is playing
+    bool isStop() const;
+
+    uint16_t m_strong;
+    uint16_t m_weak;
+    // Zero plays until the next stop
+    uint16_t m_durationms;
+};
+
+#endif // RUMBLEEVENT_H
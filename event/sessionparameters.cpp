@@ -0,0 +1,62 @@
+#include "sessionparameters.h"
+#include <algorithm>
+
+const uint32_t SessionParameters::LatestCodec;
+const uint32_t SessionParameters::CompactAxisBits;
+
+SessionParameters::SessionParameters(const uint32_t &codecVersion, const uint32_t &tickRateHz, const uint32_t &axisBits, const uint32_t &redundancy, const uint32_t &channels):
+    m_codecVersion(codecVersion),
+    m_tickRateHz(tickRateHz),
+    m_axisBits(axisBits),
+    m_redundancy(redundancy),
+    m_channels(channels)
+{
+
+}
+
+SessionParameters::SessionParameters(const ControlMessage &message): SessionParameters(baseline()) {
+    if(message.m_opcode != ControlMessage::Capabilities)
+        return;
+    message.value(ControlMessage::CodecVersion, m_codecVersion);
+    message.value(ControlMessage::TickRate, m_tickRateHz);
+    message.value(ControlMessage::AxisBits, m_axisBits);
+    message.value(ControlMessage::Redundancy, m_redundancy);
+    message.value(ControlMessage::Channels, m_channels);
+}
+
+ControlMessage SessionParameters::message() const {
+    ControlMessage message(ControlMessage::Capabilities);
+    message.setValue(ControlMessage::CodecVersion, m_codecVersion);
+    message.setValue(ControlMessage::TickRate, m_tickRateHz);
+    message.setValue(ControlMessage::AxisBits, m_axisBits);
+    message.setValue(ControlMessage::Redundancy, m_redundancy);
+    message.setValue(ControlMessage::Channels, m_channels);
+    return message;
+}
+
+SessionParameters SessionParameters::baseline() {
+    return SessionParameters();
+}
+
+SessionParameters SessionParameters::negotiate(const SessionParameters &first, const SessionParameters &second) {
+    SessionParameters session;
+    session.m_codecVersion = std::max(uint32_t(1), std::min(first.m_codecVersion, second.m_codecVersion));
+    session.m_tickRateHz = std::min(first.m_tickRateHz, second.m_tickRateHz);
+    session.m_axisBits = std::min(first.m_axisBits, second.m_axisBits);
+    session.m_redundancy = std::max(first.m_redundancy, second.m_redundancy);
+    session.m_channels = first.m_channels & second.m_channels;
+    return session;
+}
+
+bool SessionParameters::operator==(const SessionParameters &other) const {
+    return m_codecVersion == other.m_codecVersion && m_tickRateHz == other.m_tickRateHz && m_axisBits == other.m_axisBits
+        && m_redundancy == other.m_redundancy && m_channels == other.m_channels;
+}
+
+bool SessionParameters::compactCodec() const {
+    return m_codecVersion >= 2 && m_axisBits <= CompactAxisBits;
+}
+
+bool SessionParameters::hasChannel(const Channel &channel) const {
+    return m_channels & channel;
+}
@@ -0,0 +1,46 @@
+#ifndef SESSIONPARAMETERS_H
+#define SESSIONPARAMETERS_H
+
+#include "event/controlmessage.h"
+
+// What a peer supports, exchanged as Capabilities at connect, and what the two agreed on afterwards.
+// Every field is settled on its own, a peer without motion doesn't pull the codec or the rate down with it
+struct SessionParameters {
+    enum Channel : uint32_t {
+        MotionChannel = 1 << 0,
+        RumbleChannel = 1 << 1,
+        TriggerChannel = 1 << 2,
+    };
+
+    // 1 is the QDataStream compatible layout, 2 adds GamepadEvent's compact frames
+    static const uint32_t LatestCodec = 2;
+    // Compact frames carry int16 axes, finer resolutions stay on the float layout
+    static const uint32_t CompactAxisBits = 16;
+
+    SessionParameters(const uint32_t &codecVersion = 1, const uint32_t &tickRateHz = 1000, const uint32_t &axisBits = 64,
+                      const uint32_t &redundancy = 0, const uint32_t &channels = MotionChannel | RumbleChannel | TriggerChannel);
+    // Missing keys keep the baseline value
+    SessionParameters(const ControlMessage &message);
+    ControlMessage message() const;
+
+    // What a peer that never answers the handshake is taken to support, everything before it existed
+    static SessionParameters baseline();
+    // Highest codec, rate and resolution both handle, the redundancy either asked for and the channels both have.
+    // Symmetric, master and slave get the same result from the two offers
+    static SessionParameters negotiate(const SessionParameters &first, const SessionParameters &second);
+
+    bool operator==(const SessionParameters &other) const;
+    bool compactCodec() const;
+    bool hasChannel(const Channel &channel) const;
+
+    uint32_t m_codecVersion;
+    // Input updates per second the receiver consumes and the sender produces
+    uint32_t m_tickRateHz;
+    // Stick precision the peer can make use of
+    uint32_t m_axisBits;
+    // Extra copies of each acknowledged datagram
+    uint32_t m_redundancy;
+    uint32_t m_channels;
+};
+
+#endif // SESSIONPARAMETERS_H
@@ -4,12 +4,22 @@
 // Common to both
 #include "transceiver/networktransceiver.h"
 #include "widget/networktransceiverwidget.h"
+#include "common/timerwheel.h"
+#include "common/trace.h"
+#include <QSocketNotifier>
 #if defined(DRIVER)// Driver Side
 #include "emulator/genericdriveremulator.h"
 #include "driver/linuxgamepaddriver.h"
+#include "common/metrics.h"
 #elif defined(CONTROLLER)// Controller Side
 #include "emulator/androidcontrolleremulator.h"
 #include "controller/gamepadcontroller.h"
+#include "widget/touchdispatcher.h"
+#include "widget/virtualanalogstick.h"
+#include "event/rumbleevent.h"
+#include "common/vibrator.h"
+#include "controller/motionsampler.h"
+#include <algorithm>
 #endif
 
 class NetworkWorker: public QThread {
@@ -35,15 +45,48 @@ int main(int argc, char **argv) {
     qputenv("QT_ANDROID_VOLUME_KEYS", "1"); // "1" is dummy
 #endif
     QApplication app(argc, argv);
+    Trace::setThreadName("gui");
+    // Session timers of this thread all run off one timer wheel
+    QSocketNotifier timerNotifier(TimerWheel::current()->fileDescriptor(), QSocketNotifier::Read);
+    QObject::connect(&timerNotifier, &QSocketNotifier::activated, [] () {
+        TimerWheel::current()->onReadable();
+    });
 
 #if defined(DRIVER)
     NetworkWorker worker(AbstractTransceiver::Mode::Slave);
     AbstractTransceiver *transceiver = worker.networkTransceiver();
-    QObject::connect(transceiver, &AbstractTransceiver::closeCalled, &app, &QApplication::quit);
-    AbstractDriver *driver = new LinuxGamepadDriver;
+    transceiver->closeCalled.connect([&app] () { app.quit(); });
+    LinuxGamepadDriver *gamepadDriver = new LinuxGamepadDriver;
+    AbstractDriver *driver = gamepadDriver;
+    transceiver->setCapabilities(gamepadDriver->capabilities());
+    gamepadDriver->setLinkQuality(&transceiver->linkQuality());
     GenericDriverEmulator *drivemu = new GenericDriverEmulator(driver, transceiver);
+    // Force feedback goes back to the controller as soon as the game plays it
+    QSocketNotifier feedbackNotifier(driver->feedbackFileDescriptor(), QSocketNotifier::Read);
+    QObject::connect(&feedbackNotifier, &QSocketNotifier::activated, [driver] () {
+        driver->onFeedbackReadable();
+    });
+    QSocketNotifier macroNotifier(gamepadDriver->macroFileDescriptor(), QSocketNotifier::Read);
+    QObject::connect(&macroNotifier, &QSocketNotifier::activated, [gamepadDriver] () {
+        gamepadDriver->onMacroReadable();
+    });
+    QSocketNotifier syncNotifier(gamepadDriver->syncFileDescriptor(), QSocketNotifier::Read);
+    QObject::connect(&syncNotifier, &QSocketNotifier::activated, [gamepadDriver] () {
+        gamepadDriver->onSyncReadable();
+    });
+    transceiver->controlArrived.connect([driver] (std::vector<uint8_t> data) {
+        driver->onControlArrived(data);
+    });
+    driver->feedback.connect([transceiver] (std::vector<uint8_t> data) {
+        transceiver->sendData(data);
+    });
     NetworkTransceiverWidget widget((NetworkTransceiver*)transceiver);
     widget.show();
+    // Prometheus counters on 127.0.0.1 when OPENRUDDER_METRICS_PORT is set, like the daemon's --metrics-port
+    Metrics::Server metrics;
+    const uint16_t metricsPort = qEnvironmentVariableIntValue("OPENRUDDER_METRICS_PORT");
+    if(metricsPort && !metrics.start(metricsPort))
+        qWarning("Can't serve metrics on port %u", unsigned(metricsPort));
 #elif defined(CONTROLLER)
     NetworkWorker worker(AbstractTransceiver::Mode::Master);
     AbstractTransceiver *transceiver = worker.networkTransceiver();
@@ -51,13 +94,47 @@ int main(int argc, char **argv) {
     comWidget.show();
     AbstractController *controller = new GamepadController;
     AndroidControllerEmulator *conemu = new AndroidControllerEmulator(transceiver, controller);
+    // Every finger on the pad goes through one dispatcher, controls no longer accept touch themselves
+    new TouchDispatcher(conemu);
+    transceiver->controlArrived.connect([] (std::vector<uint8_t> data) {
+        if(!RumbleEvent::isRumble(data))
+            return;
+        const RumbleEvent rumble(data);
+        Vibrator::instance()->vibrate(rumble.m_strong, rumble.m_weak, rumble.m_durationms);
+    });
+    // Gyro aiming, motion only streams while connected
+    MotionSampler motionSampler;
+    QObject::connect(&motionSampler, &MotionSampler::packetReady, [transceiver] (std::vector<uint8_t> data) {
+        transceiver->sendData(data);
+    });
+    // Touch gives full float precision, the sampler caps the rate we can offer
+    const int motionRate = motionSampler.rate();
+    transceiver->setCapabilities(SessionParameters(SessionParameters::LatestCodec, motionRate, 64));
+    transceiver->sessionNegotiated.connect([&motionSampler, motionRate, conemu] (SessionParameters session) {
+        // Sticks keep their own cap, the session only lowers it when the driver consumes slower
+        for(VirtualAnalogStick *stick: conemu->findChildren <VirtualAnalogStick*> ())
+            stick->sendPolicy()->setSessionRate(session.m_tickRateHz);
+        if(!session.hasChannel(SessionParameters::MotionChannel)) {
+            motionSampler.stop();
+            return;
+        }
+        motionSampler.setRate(std::min<int>(motionRate, session.m_tickRateHz));
+        motionSampler.start();
+    });
+    transceiver->disconnected.connect([&motionSampler] (std::string) { motionSampler.stop(); });
     QObject::connect(conemu, &AbstractControllerEmulator::closeCalled, &comWidget, &QWidget::show);
     QObject::connect(conemu, &AbstractControllerEmulator::closeCalled, conemu, &QWidget::hide);
-    QObject::connect(transceiver, &AbstractTransceiver::connected, &comWidget, &QWidget::hide);
-    QObject::connect(transceiver, &AbstractTransceiver::connected, conemu, &QWidget::show);
-    QObject::connect(transceiver, &AbstractTransceiver::closeCalled, &app, &QApplication::quit);
+    transceiver->connected.connect([&comWidget, conemu] () {
+        comWidget.hide();
+        conemu->show();
+    });
+    transceiver->closeCalled.connect([&app] () { app.quit(); });
     app.installEventFilter(controller);
 #endif
 
-    return app.exec();
+    const int result = app.exec();
+    // Trace builds dump the session's timeline where OPENRUDDER_TRACE_FILE points
+    if(Trace::isEnabled() && qEnvironmentVariableIsSet("OPENRUDDER_TRACE_FILE"))
+        Trace::dump(qgetenv("OPENRUDDER_TRACE_FILE").toStdString());
+    return result;
 }
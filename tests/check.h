@@ -0,0 +1,35 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include "common/timerwheel.h"
+#include <stdio.h>
+#include <poll.h>
+
+// Minimal assertions for make check, a failed check is reported and counted but the test keeps going.
+// Each test is its own binary and returns checkResult() from main
+static int checkFailures = 0;
+
+#define CHECK(condition) do { \
+    if(!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        ++checkFailures; \
+    } \
+} while(0)
+
+static inline int checkResult(const char *name) {
+    printf("%s: %s\n", name, checkFailures ? "FAILED" : "passed");
+    return checkFailures ? 1 : 0;
+}
+
+// Runs the calling thread's timer wheel against the real clock for ms
+static inline void runFor(const uint64_t &ms) {
+    TimerWheel *wheel = TimerWheel::current();
+    const uint64_t end = wheel->now() + ms;
+    while(wheel->now() < end) {
+        struct pollfd fd = {wheel->fileDescriptor(), POLLIN, 0};
+        if(poll(&fd, 1, int(end - wheel->now())) > 0)
+            wheel->onReadable();
+    }
+}
+
+#endif // CHECK_H
@@ -0,0 +1,102 @@
+// Wire round trips of input and control frames, both GamepadEvent layouts included
+#include "event/gamepadevent.h"
+#include "event/controlmessage.h"
+#include "event/sessionparameters.h"
+#include "tests/check.h"
+#include <cmath>
+
+static void testLegacyStick() {
+    GamepadEvent event(GamepadEvent::StickMoveEvent, Button::LEFTSTICK, PointF(0.25, -0.75));
+    const std::vector<uint8_t> data = event.data();
+    CHECK(data.size() == 28);
+    CHECK(GamepadEvent::isGamepadEvent(data));
+    const GamepadEvent decoded(data);
+    CHECK(decoded.m_type == GamepadEvent::StickMoveEvent);
+    CHECK(decoded.m_button == Button::LEFTSTICK);
+    CHECK(decoded.m_value.x() == 0.25 && decoded.m_value.y() == -0.75);
+    CHECK(decoded.m_timestamp == event.m_timestamp);
+}
+
+static void testCompactStick() {
+    GamepadEvent event(GamepadEvent::StickMoveEvent, Button::RIGHTSTICK, PointF(0.5, -1));
+    const std::vector<uint8_t> data = event.data(true);
+    CHECK(data.size() == 11);
+    CHECK(data[0] == GamepadEvent::CompactTag);
+    CHECK(GamepadEvent::isGamepadEvent(data));
+    const GamepadEvent decoded(data);
+    CHECK(decoded.m_type == GamepadEvent::StickMoveEvent);
+    CHECK(decoded.m_button == Button::RIGHTSTICK);
+    // int16 axes, within one step of the original
+    CHECK(std::fabs(decoded.m_value.x() - 0.5) <= 1.0 / GamepadEvent::CompactAxisMax);
+    CHECK(std::fabs(decoded.m_value.y() + 1) <= 1.0 / GamepadEvent::CompactAxisMax);
+    CHECK(decoded.m_timestamp == event.m_timestamp);
+}
+
+static void testButtonsAndTriggers() {
+    for(const bool compact: {false, true}) {
+        const GamepadEvent press(GamepadEvent::ButtonPressEvent, Button::A);
+        const GamepadEvent pressDecoded(press.data(compact));
+        CHECK(GamepadEvent::isGamepadEvent(press.data(compact)));
+        CHECK(pressDecoded.m_type == GamepadEvent::ButtonPressEvent);
+        CHECK(pressDecoded.m_button == Button::A);
+
+        const GamepadEvent trigger(GamepadEvent::TriggerMoveEvent, Button::LEFTTRIGGER, uint16_t(700));
+        const GamepadEvent triggerDecoded(trigger.data(compact));
+        CHECK(GamepadEvent::isGamepadEvent(trigger.data(compact)));
+        CHECK(triggerDecoded.m_type == GamepadEvent::TriggerMoveEvent);
+        CHECK(triggerDecoded.m_button == Button::LEFTTRIGGER);
+        CHECK(triggerDecoded.m_trigger == 700);
+    }
+    // Clamped on construction, whatever the caller passed
+    CHECK(GamepadEvent(GamepadEvent::TriggerMoveEvent, Button::LEFTTRIGGER, uint16_t(5000)).m_trigger == GamepadEvent::TriggerMax);
+}
+
+static void testMalformed() {
+    std::vector<uint8_t> data = GamepadEvent(GamepadEvent::StickMoveEvent, Button::LEFTSTICK, PointF(1, 1)).data(true);
+    data.pop_back();
+    CHECK(!GamepadEvent::isGamepadEvent(data));
+    CHECK(!GamepadEvent::isGamepadEvent(std::vector<uint8_t>()));
+    // Unknown type
+    CHECK(!GamepadEvent::isGamepadEvent(std::vector<uint8_t>{GamepadEvent::CompactTag, 42, 0}));
+    // Control messages are never input
+    CHECK(!GamepadEvent::isGamepadEvent(ControlMessage(ControlMessage::Quit).data()));
+}
+
+static void testControlMessage() {
+    ControlMessage message(ControlMessage::Config);
+    message.setValue(ControlMessage::JitterBuffer, 1);
+    message.setValue(ControlMessage::StickPrediction, 0xdeadbeef);
+    // Setting a key again replaces it
+    message.setValue(ControlMessage::JitterBuffer, 0);
+    const std::vector<uint8_t> data = message.data();
+    CHECK(ControlMessage::isControl(data));
+    CHECK(data.size() == 1 + 2 * 5);
+    const ControlMessage decoded(data);
+    uint32_t value = 1;
+    CHECK(decoded.m_opcode == ControlMessage::Config);
+    CHECK(decoded.value(ControlMessage::JitterBuffer, value) && value == 0);
+    CHECK(decoded.value(ControlMessage::StickPrediction, value) && value == 0xdeadbeef);
+    CHECK(!decoded.value(ControlMessage::TickRate, value));
+}
+
+static void testSessionMessage() {
+    const SessionParameters parameters(2, 500, 12, 1, SessionParameters::RumbleChannel);
+    CHECK(SessionParameters(parameters.message()) == parameters);
+    // Missing keys keep the baseline
+    ControlMessage partial(ControlMessage::Capabilities);
+    partial.setValue(ControlMessage::TickRate, 250);
+    const SessionParameters decoded(partial);
+    CHECK(decoded.m_tickRateHz == 250);
+    CHECK(decoded.m_codecVersion == SessionParameters::baseline().m_codecVersion);
+    CHECK(decoded.m_channels == SessionParameters::baseline().m_channels);
+}
+
+int main() {
+    testLegacyStick();
+    testCompactStick();
+    testButtonsAndTriggers();
+    testMalformed();
+    testControlMessage();
+    testSessionMessage();
+    return checkResult("codec");
+}
@@ -0,0 +1,74 @@
+// Redundant input copies: only the first of each sequence gets through, in any arrival order and across the wrap
+#include "transceiver/sequencefilter.h"
+#include "event/gamepadevent.h"
+#include "tests/check.h"
+
+static bool deliver(SequenceFilter &filter, const uint16_t &sequence, const std::vector<uint8_t> &frame, std::vector<uint8_t> &delivered) {
+    delivered = SequenceFilter::wrap(sequence, frame);
+    return filter.accept(delivered);
+}
+
+static void testDuplicates() {
+    SequenceFilter filter;
+    const std::vector<uint8_t> press = GamepadEvent(GamepadEvent::ButtonPressEvent, Button::A).data(true);
+    const std::vector<uint8_t> release = GamepadEvent(GamepadEvent::ButtonReleaseEvent, Button::A).data(true);
+    std::vector<uint8_t> delivered;
+    CHECK(deliver(filter, 7, press, delivered) && delivered == press);
+    CHECK(!deliver(filter, 7, press, delivered));
+    CHECK(deliver(filter, 8, release, delivered) && delivered == release);
+    // A copy of the press reordered behind the release mustn't press the button again
+    CHECK(!deliver(filter, 7, press, delivered));
+    CHECK(!deliver(filter, 8, release, delivered));
+}
+
+static void testReordered() {
+    SequenceFilter filter;
+    const std::vector<uint8_t> frame(4, 1);
+    std::vector<uint8_t> delivered;
+    CHECK(deliver(filter, 10, frame, delivered));
+    // Late but never seen, still passed on once
+    CHECK(deliver(filter, 9, frame, delivered));
+    CHECK(!deliver(filter, 9, frame, delivered));
+    CHECK(deliver(filter, 40, frame, delivered));
+    CHECK(deliver(filter, 12, frame, delivered));
+    // Beyond the window it can't be told from a copy
+    CHECK(!deliver(filter, uint16_t(40 - int(SequenceFilter::Window)), frame, delivered));
+    CHECK(deliver(filter, 40 + SequenceFilter::Window + 5, frame, delivered));
+    CHECK(!deliver(filter, 40, frame, delivered));
+}
+
+static void testWrap() {
+    SequenceFilter filter;
+    const std::vector<uint8_t> frame(4, 2);
+    std::vector<uint8_t> delivered;
+    CHECK(deliver(filter, 65534, frame, delivered));
+    CHECK(deliver(filter, 0, frame, delivered));
+    CHECK(deliver(filter, 65535, frame, delivered));
+    CHECK(!deliver(filter, 65534, frame, delivered));
+    CHECK(!deliver(filter, 0, frame, delivered));
+    CHECK(deliver(filter, 1, frame, delivered));
+}
+
+static void testPassThroughAndReset() {
+    SequenceFilter filter;
+    const std::vector<uint8_t> frame = GamepadEvent(GamepadEvent::StickMoveEvent, Button::LEFTSTICK, PointF(0.5, 0.5)).data();
+    std::vector<uint8_t> plain = frame;
+    CHECK(filter.accept(plain) && plain == frame);
+    CHECK(filter.accept(plain) && plain == frame);
+    std::vector<uint8_t> truncated = {SequenceFilter::Tag, 0, 1};
+    CHECK(!filter.accept(truncated));
+
+    std::vector<uint8_t> delivered;
+    CHECK(deliver(filter, 3, frame, delivered));
+    filter.reset();
+    // A new session starts its sequence over
+    CHECK(deliver(filter, 3, frame, delivered));
+}
+
+int main() {
+    testDuplicates();
+    testReordered();
+    testWrap();
+    testPassThroughAndReset();
+    return checkResult("sequencefilter");
+}
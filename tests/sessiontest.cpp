@@ -0,0 +1,74 @@
+// SessionParameters::negotiate and the Capabilities handshake between a master and a slave wired back to back
+#include "transceiver/sessionhandshake.h"
+#include "tests/check.h"
+
+static void testNegotiate() {
+    const SessionParameters master(2, 120, 64, 0, SessionParameters::MotionChannel | SessionParameters::RumbleChannel);
+    const SessionParameters slave(2, 1000, 12, 2, SessionParameters::RumbleChannel | SessionParameters::TriggerChannel);
+    const SessionParameters session = SessionParameters::negotiate(master, slave);
+    CHECK(session == SessionParameters::negotiate(slave, master));
+    CHECK(session.m_codecVersion == 2);
+    CHECK(session.m_tickRateHz == 120);
+    CHECK(session.m_axisBits == 12);
+    CHECK(session.m_redundancy == 2);
+    CHECK(session.m_channels == SessionParameters::RumbleChannel);
+    CHECK(session.compactCodec());
+    CHECK(!session.hasChannel(SessionParameters::MotionChannel));
+
+    // A peer from before the handshake pulls the codec down to the float layout
+    const SessionParameters old = SessionParameters::negotiate(master, SessionParameters::baseline());
+    CHECK(old.m_codecVersion == 1);
+    CHECK(!old.compactCodec());
+    // Finer than int16 stays on the float layout too
+    CHECK(!SessionParameters(2, 1000, 32).compactCodec());
+}
+
+static void testHandshake() {
+    SessionHandshake master, slave;
+    master.setCapabilities(SessionParameters(2, 120, 64, 1));
+    slave.setCapabilities(SessionParameters(2, 1000, 12, 0, SessionParameters::RumbleChannel));
+    int masterSettled = 0, slaveSettled = 0, masterSent = 0;
+    bool dropFirst = true;
+    // The first offer is lost, the retransmit has to carry the exchange
+    master.setSend([&] (const std::vector<uint8_t> &data) {
+        ++masterSent;
+        if(dropFirst) {
+            dropFirst = false;
+            return;
+        }
+        slave.onCapabilities(data);
+    });
+    slave.setSend([&master] (const std::vector<uint8_t> &data) { master.onCapabilities(data); });
+    master.setCallback([&masterSettled] (const SessionParameters &) { ++masterSettled; });
+    slave.setCallback([&slaveSettled] (const SessionParameters &) { ++slaveSettled; });
+
+    slave.await();
+    master.offer();
+    CHECK(!master.isNegotiated());
+    runFor(SessionHandshake::RetransmitPeriodms * 3);
+    CHECK(master.isNegotiated() && slave.isNegotiated());
+    CHECK(master.session() == slave.session());
+    CHECK(master.session().m_tickRateHz == 120 && master.session().m_redundancy == 1);
+    CHECK(masterSettled == 1 && slaveSettled == 1);
+    // Answered, so the master stops retransmitting
+    CHECK(masterSent == 2);
+}
+
+static void testBaselineFallback() {
+    SessionHandshake slave;
+    slave.setCapabilities(SessionParameters(2, 1000, 12));
+    slave.setSend([] (const std::vector<uint8_t> &) {});
+    int settled = 0;
+    slave.setCallback([&settled] (const SessionParameters &) { ++settled; });
+    slave.await();
+    runFor(SessionHandshake::RetransmitPeriodms * SessionHandshake::MaxAttempts + 50);
+    CHECK(settled == 1);
+    CHECK(slave.session() == SessionParameters::negotiate(slave.capabilities(), SessionParameters::baseline()));
+}
+
+int main() {
+    testNegotiate();
+    testHandshake();
+    testBaselineFallback();
+    return checkResult("session");
+}
@@ -0,0 +1,226 @@
+// Shared memory ring: framing across the wrap, a full ring, wakeups and a corrupted size from the producer,
+// then a master and slave SharedMemoryTransceiver talking over a real socket
+#include "transceiver/sharedmemoryring.h"
+#include "transceiver/sharedmemorytransceiver.h"
+#include "event/gamepadevent.h"
+#include "event/rumbleevent.h"
+#include "tests/check.h"
+#include <string.h>
+#include <unistd.h>
+#include <cmath>
+#include <functional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static std::vector<uint8_t> frameOf(const uint32_t &size, const uint8_t &fill) {
+    std::vector<uint8_t> frame(size);
+    for(uint32_t i = 0; i < size; ++i)
+        frame[i] = uint8_t(fill + i);
+    return frame;
+}
+
+static bool push(SharedMemoryRing &ring, const std::vector<uint8_t> &frame) {
+    return ring.push(frame.data(), frame.size());
+}
+
+// The producer maps the same memory through its own copies of the descriptors, as it would in another process
+static bool attachProducer(SharedMemoryRing &producer, const SharedMemoryRing &consumer) {
+    return producer.attach(dup(consumer.memoryFileDescriptor()), dup(consumer.eventFileDescriptor()));
+}
+
+static bool wakeupPending(const SharedMemoryRing &ring) {
+    struct pollfd fd = {ring.eventFileDescriptor(), POLLIN, 0};
+    return poll(&fd, 1, 0) > 0;
+}
+
+static void testWrap() {
+    SharedMemoryRing consumer, producer;
+    CHECK(consumer.create(64));
+    CHECK(attachProducer(producer, consumer));
+    std::vector<uint8_t> frame;
+    // 24 bytes each with the length, the third lap can't fit in the last 16 and has to wrap
+    for(uint8_t lap = 0; lap < 8; ++lap) {
+        CHECK(push(producer, frameOf(20, lap)));
+        CHECK(push(producer, frameOf(13, lap + 100)));
+        CHECK(consumer.pop(frame) && frame == frameOf(20, lap));
+        CHECK(consumer.pop(frame) && frame == frameOf(13, lap + 100));
+        CHECK(!consumer.pop(frame));
+    }
+    // Empty frames take only the length
+    CHECK(push(producer, std::vector<uint8_t>()));
+    CHECK(consumer.pop(frame) && frame.empty());
+}
+
+static void testFull() {
+    SharedMemoryRing consumer, producer;
+    CHECK(consumer.create(64));
+    CHECK(attachProducer(producer, consumer));
+    // Half the ring at most, a bigger frame could never be placed after a wrap
+    CHECK(!push(producer, frameOf(29, 0)));
+    int pushed = 0;
+    while(pushed < 100 && push(producer, frameOf(12, uint8_t(pushed))))
+        ++pushed;
+    CHECK(pushed == 4);
+    std::vector<uint8_t> frame;
+    CHECK(consumer.pop(frame) && frame == frameOf(12, 0));
+    CHECK(push(producer, frameOf(12, 4)));
+    CHECK(!push(producer, frameOf(12, 5)));
+    // The rejected frame left nothing behind
+    for(uint8_t i = 1; i <= 4; ++i)
+        CHECK(consumer.pop(frame) && frame == frameOf(12, i));
+    CHECK(!consumer.pop(frame));
+}
+
+static void testWakeup() {
+    SharedMemoryRing consumer, producer;
+    CHECK(consumer.create());
+    CHECK(attachProducer(producer, consumer));
+    std::vector<uint8_t> frame;
+    // Armed from creation, the first push wakes the consumer
+    CHECK(push(producer, frameOf(8, 1)));
+    CHECK(wakeupPending(consumer));
+    consumer.clearWakeup();
+    CHECK(!wakeupPending(consumer));
+    // Not rearmed, pushes while the consumer is awake cost no write
+    CHECK(push(producer, frameOf(8, 2)));
+    CHECK(!wakeupPending(consumer));
+    // Frames are still queued, arming has to fail so they're popped before sleeping
+    CHECK(!consumer.arm());
+    while(consumer.pop(frame)) {}
+    CHECK(consumer.arm());
+    CHECK(!wakeupPending(consumer));
+    CHECK(push(producer, frameOf(8, 3)));
+    CHECK(wakeupPending(consumer));
+    // One wakeup per arm, however many frames follow
+    consumer.clearWakeup();
+    CHECK(push(producer, frameOf(8, 4)));
+    CHECK(!wakeupPending(consumer));
+    CHECK(consumer.pop(frame) && frame == frameOf(8, 3));
+    CHECK(consumer.pop(frame) && frame == frameOf(8, 4));
+}
+
+static void testMalformed() {
+    SharedMemoryRing consumer, producer;
+    CHECK(consumer.create(256));
+    CHECK(attachProducer(producer, consumer));
+    const std::vector<uint8_t> marked = {0xde, 0xad, 0xbe, 0xef, 0x5a, 0xa5, 0x3c, 0xc3};
+    CHECK(push(producer, frameOf(8, 0)));
+    CHECK(push(producer, marked));
+
+    // A misbehaving producer overwrites the length of a queued frame through the shared mapping
+    struct stat status;
+    CHECK(fstat(consumer.memoryFileDescriptor(), &status) == 0);
+    uint8_t *memory = static_cast<uint8_t*>(mmap(nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, consumer.memoryFileDescriptor(), 0));
+    CHECK(memory != MAP_FAILED);
+    if(memory == MAP_FAILED)
+        return;
+    uint8_t *found = static_cast<uint8_t*>(memmem(memory, status.st_size, marked.data(), marked.size()));
+    CHECK(found && found - memory >= 4);
+    if(found) {
+        const uint32_t bogus = 0x7fffffff;
+        memcpy(found - sizeof(bogus), &bogus, sizeof(bogus));
+    }
+    munmap(memory, status.st_size);
+
+    std::vector<uint8_t> frame;
+    CHECK(consumer.pop(frame) && frame == frameOf(8, 0));
+    // The rest of the queue is dropped instead of read out of bounds, later frames go through again
+    CHECK(!consumer.pop(frame));
+    CHECK(!consumer.pop(frame));
+    CHECK(push(producer, frameOf(8, 9)));
+    CHECK(consumer.pop(frame) && frame == frameOf(8, 9));
+
+    // Memory that wasn't set up by create is refused
+    SharedMemoryRing stranger;
+    const int bogusMemory = memfd_create("openrudder-test", MFD_CLOEXEC);
+    CHECK(bogusMemory >= 0 && ftruncate(bogusMemory, 4096) == 0);
+    CHECK(!stranger.attach(bogusMemory, dup(consumer.eventFileDescriptor())));
+    CHECK(!stranger.isAttached());
+}
+
+// Services both ends and the timer wheel until done returns true or ms pass
+static bool pump(AbstractTransceiver &master, AbstractTransceiver &slave, const uint64_t &ms, const std::function<bool()> &done) {
+    TimerWheel *wheel = TimerWheel::current();
+    const uint64_t end = wheel->now() + ms;
+    while(!done() && wheel->now() < end) {
+        struct pollfd fds[3] = {
+            {master.fileDescriptor(), POLLIN, 0},
+            {slave.fileDescriptor(), POLLIN, 0},
+            {wheel->fileDescriptor(), POLLIN, 0},
+        };
+        if(poll(fds, 3, 10) <= 0)
+            continue;
+        if(fds[0].revents)
+            master.onReadable();
+        if(fds[1].revents)
+            slave.onReadable();
+        if(fds[2].revents)
+            wheel->onReadable();
+    }
+    return done();
+}
+
+static void testRoundTrip() {
+    const std::string path = "/tmp/openrudder-test-" + std::to_string(getpid()) + ".sock";
+    SharedMemoryTransceiver slave(AbstractTransceiver::Slave, path);
+    SharedMemoryTransceiver master(AbstractTransceiver::Master, path);
+    slave.setCapabilities(SessionParameters(2, 1000, 16));
+    master.setCapabilities(SessionParameters(2, 250, 16));
+
+    int slaveConnected = 0, masterConnected = 0, slaveSessions = 0, masterSessions = 0, slaveDisconnected = 0;
+    std::vector<std::vector<uint8_t>> input, feedback;
+    slave.connected.connect([&slaveConnected] () { ++slaveConnected; });
+    master.connected.connect([&masterConnected] () { ++masterConnected; });
+    slave.sessionNegotiated.connect([&slaveSessions] (SessionParameters) { ++slaveSessions; });
+    master.sessionNegotiated.connect([&masterSessions] (SessionParameters) { ++masterSessions; });
+    slave.disconnected.connect([&slaveDisconnected] (std::string) { ++slaveDisconnected; });
+    slave.dataArrived.connect([&input] (std::vector<uint8_t> data) { input.push_back(data); });
+    master.controlArrived.connect([&feedback] (std::vector<uint8_t> data) {
+        if(RumbleEvent::isRumble(data))
+            feedback.push_back(data);
+    });
+
+    slave.onStart();
+    CHECK(slave.state() == SharedMemoryTransceiver::Listen);
+    master.onStart();
+    CHECK(master.state() == SharedMemoryTransceiver::Handshake);
+    CHECK(pump(master, slave, 1000, [&] () { return slaveSessions && masterSessions; }));
+    CHECK(slaveConnected == 1 && masterConnected == 1 && master.state() == SharedMemoryTransceiver::Connected);
+    CHECK(master.session() == slave.session() && slave.session().m_tickRateHz == 250);
+
+    // Input goes through the ring in the negotiated codec
+    const GamepadEvent press(GamepadEvent::ButtonPressEvent, Button::A);
+    const GamepadEvent stick(GamepadEvent::StickMoveEvent, Button::LEFTSTICK, PointF(0.5, -0.25));
+    CHECK(master.sendData(press.data(), true) > 0);
+    CHECK(master.sendData(stick.data()) > 0);
+    CHECK(pump(master, slave, 1000, [&input] () { return input.size() >= 2; }));
+    CHECK(input.size() == 2);
+    if(input.size() == 2) {
+        CHECK(input[0][0] == GamepadEvent::CompactTag);
+        CHECK(GamepadEvent(input[0]).m_type == GamepadEvent::ButtonPressEvent && GamepadEvent(input[0]).m_button == Button::A);
+        const GamepadEvent received(input[1]);
+        CHECK(received.m_button == Button::LEFTSTICK && std::abs(received.m_value.x() - 0.5) < 1e-3 && std::abs(received.m_value.y() + 0.25) < 1e-3);
+    }
+
+    // Feedback comes back over the socket
+    const RumbleEvent rumble(40000, 20000, 150);
+    CHECK(slave.sendData(rumble.data()) > 0);
+    CHECK(pump(master, slave, 1000, [&feedback] () { return !feedback.empty(); }));
+    CHECK(feedback.size() == 1 && feedback[0] == rumble.data());
+
+    // The producer hanging up puts the slave back to listening
+    master.onStop();
+    CHECK(pump(master, slave, 1000, [&slaveDisconnected] () { return slaveDisconnected > 0; }));
+    CHECK(slave.state() == SharedMemoryTransceiver::Listen);
+    slave.onStop();
+    CHECK(access(path.c_str(), F_OK) != 0);
+}
+
+int main() {
+    testWrap();
+    testFull();
+    testWakeup();
+    testMalformed();
+    testRoundTrip();
+    return checkResult("sharedmemoryring");
+}
@@ -0,0 +1,78 @@
+// Stick prediction: extrapolation while a packet is late, the walk back once the gap outlasts the horizon
+#include "driver/stickpredictor.h"
+#include "tests/check.h"
+#include <cmath>
+
+static bool near(const float &a, const float &b) {
+    return std::fabs(a - b) < 1e-4f;
+}
+
+// Samples every 10ms moving right by 0.05 each, ending at x = 0.3
+static void feed(StickPredictor &predictor, uint32_t &now) {
+    float x, y;
+    for(int i = 0; i <= 6; ++i) {
+        predictor.update(Button::LEFTSTICK, 0.05f * i, 0, now, x, y);
+        CHECK(near(x, 0.05f * i) && near(y, 0));
+        now += 10000;
+    }
+    now -= 10000;
+}
+
+static void testExtrapolation() {
+    StickPredictor predictor;
+    uint32_t now = 1000000;
+    feed(predictor, now);
+    float x, y;
+    // Next packet still due, nothing to predict
+    CHECK(!predictor.extrapolate(Button::LEFTSTICK, now + 12000, x, y));
+    CHECK(predictor.extrapolate(Button::LEFTSTICK, now + 20000, x, y));
+    CHECK(x > 0.3f && x < 0.45f && near(y, 0));
+    // The late packet arrives, the output converges instead of jumping
+    float outX, outY;
+    predictor.update(Button::LEFTSTICK, 0.35f, 0, now + 21000, outX, outY);
+    CHECK(outX <= x + 1e-4f);
+}
+
+static void testSilencePastHorizon() {
+    StickPredictor predictor;
+    predictor.setMaxGap(50000);
+    predictor.setMaxCorrection(0.05f);
+    uint32_t now = 1000000;
+    feed(predictor, now);
+    float x, y;
+    CHECK(predictor.extrapolate(Button::LEFTSTICK, now + 40000, x, y));
+    const float predicted = x;
+    CHECK(predicted > 0.4f);
+    // Past the horizon the output walks back to the last real sample in bounded steps, then stays there
+    float previous = predicted;
+    int steps = 0;
+    for(uint32_t t = now + 60000; predictor.extrapolate(Button::LEFTSTICK, t, x, y) && steps < 100; t += 10000, ++steps) {
+        CHECK(x < previous && previous - x <= 0.05f + 1e-4f);
+        previous = x;
+    }
+    CHECK(steps > 1 && steps < 100);
+    CHECK(near(previous, 0.3f));
+    CHECK(!predictor.extrapolate(Button::LEFTSTICK, now + 2000000, x, y));
+    // Back at the real position, the next sample passes straight through
+    predictor.update(Button::LEFTSTICK, 0.1f, 0.2f, now + 2010000, x, y);
+    CHECK(near(x, 0.1f) && near(y, 0.2f));
+}
+
+static void testHeartbeat() {
+    StickPredictor predictor;
+    predictor.setHeartbeatTimeout(100000);
+    CHECK(!predictor.heartbeatExpired(5000000));
+    predictor.heartbeat(1000000);
+    CHECK(!predictor.heartbeatExpired(1090000));
+    // Anything from the controller refreshes it, not only stick data
+    predictor.heartbeat(1090000);
+    CHECK(!predictor.heartbeatExpired(1150000));
+    CHECK(predictor.heartbeatExpired(1200000));
+}
+
+int main() {
+    testExtrapolation();
+    testSilencePastHorizon();
+    testHeartbeat();
+    return checkResult("stickpredictor");
+}
@@ -0,0 +1,98 @@
+// Timer wheel against the real clock: deadlines across the level 0/1/2 boundaries, so every cascade
+// path runs, plus periodic timers and callbacks that stop, restart or destroy timers
+#include "common/timerwheel.h"
+#include "tests/check.h"
+#include <memory>
+#include <vector>
+
+// Slack for a loaded machine, the wheel itself is exact to the tick
+static const uint64_t Slackms = 30;
+
+static void testDeadlines() {
+    // Level 0 covers 64 ticks, level 1 4096, 4100 ms has to come down from level 2
+    const uint32_t deadlines[] = {1, 5, 63, 64, 65, 127, 128, 200, 700, 4100};
+    const int count = sizeof(deadlines) / sizeof(deadlines[0]);
+    TimerWheel *wheel = TimerWheel::current();
+    std::vector<uint64_t> fired(count, 0);
+    std::vector<int> calls(count, 0);
+    std::unique_ptr<TimerWheel::Timer> timers[count];
+    const uint64_t start = wheel->now();
+    for(int i = 0; i < count; ++i) {
+        timers[i].reset(new TimerWheel::Timer);
+        timers[i]->setSingleShot(true);
+        timers[i]->setCallback([&fired, &calls, wheel, i] () {
+            fired[i] = wheel->now();
+            ++calls[i];
+        });
+        timers[i]->start(deadlines[i]);
+    }
+    runFor(deadlines[count - 1] + Slackms + 20);
+    for(int i = 0; i < count; ++i) {
+        CHECK(calls[i] == 1);
+        CHECK(fired[i] >= start + deadlines[i]);
+        CHECK(fired[i] <= start + deadlines[i] + Slackms);
+        CHECK(!timers[i]->isActive());
+    }
+}
+
+static void testPeriodic() {
+    TimerWheel::Timer timer;
+    int calls = 0;
+    timer.setCallback([&calls] () { ++calls; });
+    timer.start(10);
+    runFor(105);
+    timer.stop();
+    // Deadlines advance from the previous deadline, so no drift over ten periods
+    CHECK(calls >= 9 && calls <= 11);
+    runFor(30);
+    CHECK(calls <= 11);
+}
+
+static void testStopAndRestart() {
+    TimerWheel::Timer stopped, restarted, other;
+    int stoppedCalls = 0, restartedCalls = 0;
+    stopped.setSingleShot(true);
+    stopped.setCallback([&stoppedCalls] () { ++stoppedCalls; });
+    stopped.start(20);
+    // Stopped from another timer's callback before it's due
+    other.setSingleShot(true);
+    other.setCallback([&stopped] () { stopped.stop(); });
+    other.start(5);
+    // Restarts itself once from its own callback
+    restarted.setSingleShot(true);
+    restarted.setCallback([&restarted, &restartedCalls] () {
+        if(++restartedCalls == 1)
+            restarted.start(10);
+    });
+    restarted.start(10);
+    runFor(60);
+    CHECK(stoppedCalls == 0);
+    CHECK(restartedCalls == 2);
+}
+
+static void testDestroyInCallback() {
+    TimerWheel::Timer *doomed = new TimerWheel::Timer;
+    TimerWheel::Timer sibling;
+    int siblingCalls = 0;
+    doomed->setSingleShot(true);
+    doomed->setCallback([&doomed] () {
+        delete doomed;
+        doomed = nullptr;
+    });
+    sibling.setSingleShot(true);
+    sibling.setCallback([&siblingCalls] () { ++siblingCalls; });
+    // Same tick, so both sit in the slot being fired
+    doomed->start(15);
+    sibling.start(15);
+    runFor(40);
+    CHECK(doomed == nullptr);
+    CHECK(siblingCalls == 1);
+}
+
+int main() {
+    testDeadlines();
+    testPeriodic();
+    testStopAndRestart();
+    testDestroyInCallback();
+    return checkResult("timerwheel");
+}
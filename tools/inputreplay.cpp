@@ -0,0 +1,114 @@
+// Feeds a session recorded with LinuxGamepadDriver::startRecording back through the driver.
+// Usage: inputreplay [--fast] [--jitter-buffer] [--predict] [--from <seconds>] [--loop <count>] <log>
+#include "driver/linuxgamepaddriver.h"
+#include "driver/inputrecorder.h"
+#include "common/timerwheel.h"
+#include <poll.h>
+#include <time.h>
+#include <string>
+
+// Services the driver's timers, sync tick and macros until deadline, like the daemon's loop would.
+// A deadline already past polls once without waiting
+static void runUntil(LinuxGamepadDriver &driver, const uint64_t &deadline) {
+    struct pollfd fds[3] = {
+        {TimerWheel::current()->fileDescriptor(), POLLIN, 0},
+        {driver.macroFileDescriptor(), POLLIN, 0},
+        {driver.syncFileDescriptor(), POLLIN, 0},
+    };
+    uint64_t now = monotonicNanos();
+    do {
+        const uint64_t remaining = deadline > now ? deadline - now : 0;
+        struct timespec timeout;
+        timeout.tv_sec = remaining / 1000000000ull;
+        timeout.tv_nsec = remaining % 1000000000ull;
+        if(ppoll(fds, 3, &timeout, nullptr) > 0) {
+            if(fds[0].revents)
+                TimerWheel::current()->onReadable();
+            if(fds[1].revents)
+                driver.onMacroReadable();
+            if(fds[2].revents)
+                driver.onSyncReadable();
+        }
+        now = monotonicNanos();
+    } while(now < deadline);
+}
+
+int main(int argc, char **argv) {
+    bool fast = false, jitterBuffer = false, predict = false;
+    uint64_t from = 0;
+    int loops = 1;
+    std::string path;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(arg == "--fast") {
+            fast = true;
+        } else if(arg == "--jitter-buffer") {
+            jitterBuffer = true;
+        } else if(arg == "--predict") {
+            predict = true;
+        } else if(arg == "--from" && i + 1 < argc) {
+            from = uint64_t(atof(argv[++i]) * 1000000);
+        } else if(arg == "--loop" && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        } else {
+            path = arg;
+        }
+    }
+    if(path.empty()) {
+        printf("Usage: %s [--fast] [--jitter-buffer] [--predict] [--from <seconds>] [--loop <count>] <log>\n"
+               "  Replays at the recorded pace, running the sync tick, macros, jitter buffer and prediction timers\n"
+               "  --fast  As fast as possible, each frame flushed right away. Timers only fire when their real\n"
+               "          deadline passes, so jitter buffer, prediction and macro timing are barely exercised\n", argv[0]);
+        return 1;
+    }
+
+    InputLogReader reader;
+    if(!reader.open(path))
+        return 1;
+
+    LinuxGamepadDriver *driver = new LinuxGamepadDriver;
+    // Without the device every frame takes the write failure path, nothing worth replaying or profiling
+    if(!driver->isOpen()) {
+        fprintf(stderr, "Can't create the uinput device, check access to /dev/uinput\n");
+        delete driver;
+        return 1;
+    }
+    driver->setJitterBufferEnabled(jitterBuffer);
+    driver->setStickPredictionEnabled(predict);
+    driver->onConnected();
+
+    uint64_t frames = 0;
+    const uint64_t started = monotonicNanos();
+    for(int loop = 0; loops <= 0 || loop < loops; ++loop) {
+        reader.seek(from);
+        InputLogReader::Frame frame;
+        bool first = true;
+        uint64_t origin = 0, startElapsed = 0;
+        while(reader.next(frame)) {
+            if(frame.elapsed < from)
+                continue;
+            if(!fast) {
+                // Absolute deadlines so wakeup overshoot doesn't accumulate over the session
+                if(first) {
+                    origin = monotonicNanos();
+                    startElapsed = frame.elapsed;
+                }
+                runUntil(*driver, origin + (frame.elapsed - startElapsed) * 1000);
+            }
+            first = false;
+            driver->onDataArrived(std::vector<uint8_t>(frame.data, frame.data + frame.size));
+            // Paced replays leave the frame to the sync tick, a fast one has no time for it to come up
+            if(fast) {
+                runUntil(*driver, 0);
+                driver->flush();
+            }
+            ++frames;
+        }
+    }
+    const double seconds = (monotonicNanos() - started) / 1e9;
+    printf("Replayed %llu frames in %.3f s\n", (unsigned long long)frames, seconds);
+
+    driver->onDisconnect();
+    delete driver;
+    return 0;
+}
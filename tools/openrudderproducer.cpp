@@ -0,0 +1,133 @@
+// Same-host producer for openrudderd --local: reads input commands from stdin and writes them straight
+// into the driver's shared memory ring, rumble from the driver is printed to stdout.
+// Usage: openrudderproducer [--socket <path>] [--verbose]
+//   press <button> / release <button>   buttons by label, A, START, LEFTBUMPER...
+//   stick <LEFTSTICK|RIGHTSTICK> <x> <y> -1 to 1, y up
+//   trigger <LEFTTRIGGER|RIGHTTRIGGER> <value> 0 to 1023
+#include "transceiver/sharedmemorytransceiver.h"
+#include "event/gamepadevent.h"
+#include "event/rumbleevent.h"
+#include "common/timerwheel.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sstream>
+#include <string>
+
+// False with nothing sent when the line isn't a command, blank lines and # comments are fine
+static bool sendCommand(AbstractTransceiver &transceiver, const std::string &line) {
+    std::istringstream words(line);
+    std::string command, label;
+    if(!(words >> command) || command[0] == '#')
+        return true;
+    words >> label;
+    const Button button = buttonForLabel(label);
+    if(button == Button::COUNT)
+        return false;
+
+    if(command == "press" || command == "release") {
+        const GamepadEvent::Type type = command == "press" ? GamepadEvent::ButtonPressEvent : GamepadEvent::ButtonReleaseEvent;
+        return transceiver.sendData(GamepadEvent(type, button).data(), true) >= 0;
+    }
+    if(command == "stick" && (button == Button::LEFTSTICK || button == Button::RIGHTSTICK)) {
+        double x, y;
+        if(!(words >> x >> y))
+            return false;
+        return transceiver.sendData(GamepadEvent(GamepadEvent::StickMoveEvent, button, PointF(x, y)).data()) >= 0;
+    }
+    if(command == "trigger" && (button == Button::LEFTTRIGGER || button == Button::RIGHTTRIGGER)) {
+        unsigned value;
+        if(!(words >> value) || value > GamepadEvent::TriggerMax)
+            return false;
+        return transceiver.sendData(GamepadEvent(GamepadEvent::TriggerMoveEvent, button, uint16_t(value)).data()) >= 0;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    std::string socketPath = SharedMemoryTransceiver::defaultPath();
+    bool verbose = false;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if(arg == "--verbose") {
+            verbose = true;
+        } else {
+            printf("Usage: %s [--socket <path>] [--verbose]\n"
+                   "  Reads one command per line from stdin and sends it to openrudderd --local\n"
+                   "  press <button>, release <button>, stick <LEFTSTICK|RIGHTSTICK> <x> <y>,\n"
+                   "  trigger <LEFTTRIGGER|RIGHTTRIGGER> <0-1023>\n", argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    SharedMemoryTransceiver transceiver(AbstractTransceiver::Master, socketPath);
+    transceiver.setCapabilities(SessionParameters(2, 1000, 16));
+    bool connected = false, running = true;
+    transceiver.connected.connect([&connected, verbose] () {
+        connected = true;
+        if(verbose)
+            fprintf(stderr, "Connected\n");
+    });
+    transceiver.disconnected.connect([&running] (std::string) {
+        running = false;
+    });
+    transceiver.closeCalled.connect([&running] () {
+        running = false;
+    });
+    transceiver.error.connect([] (std::string error) {
+        fprintf(stderr, "%s\n", error.c_str());
+    });
+    transceiver.controlArrived.connect([] (std::vector<uint8_t> data) {
+        if(!RumbleEvent::isRumble(data))
+            return;
+        const RumbleEvent rumble(data);
+        printf("rumble %u %u %u\n", rumble.m_strong, rumble.m_weak, rumble.m_durationms);
+        fflush(stdout);
+    });
+
+    transceiver.onStart();
+    if(transceiver.fileDescriptor() < 0)
+        return 1;
+
+    std::string pending;
+    char buffer[4096];
+    while(running) {
+        // Input waits until the ring is mapped, commands typed before that stay in the pipe
+        struct pollfd fds[3] = {
+            {transceiver.fileDescriptor(), POLLIN, 0},
+            {TimerWheel::current()->fileDescriptor(), POLLIN, 0},
+            {connected ? STDIN_FILENO : -1, POLLIN, 0},
+        };
+        if(poll(fds, 3, -1) < 0) {
+            if(errno == EINTR)
+                continue;
+            fprintf(stderr, "Event loop failed: %s\n", strerror(errno));
+            break;
+        }
+        if(fds[0].revents)
+            transceiver.onReadable();
+        if(fds[1].revents)
+            TimerWheel::current()->onReadable();
+        if(!running || !fds[2].revents)
+            continue;
+
+        const ssize_t size = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if(size <= 0) {
+            transceiver.onStop();
+            break;
+        }
+        pending.append(buffer, size);
+        size_t end;
+        while((end = pending.find('\n')) != std::string::npos) {
+            const std::string line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if(!sendCommand(transceiver, line))
+                fprintf(stderr, "Can't send: %s\n", line.c_str());
+        }
+    }
+    return 0;
+}
@@ -1,8 +1,15 @@
 #ifndef ABSTRACTTRANSCEIVER_H
 #define ABSTRACTTRANSCEIVER_H
 
+#include <cstdint>
+#include <string>
 #include <vector>
-//#include <QObject>
+#include "sigslot/signal.h"
+#include "transceiver/sessionhandshake.h"
+#include "transceiver/transportmetrics.h"
+#include "transceiver/linkquality.h"
+#include "transceiver/sequencefilter.h"
+#include "event/gamepadevent.h"
 
 class AbstractTransceiver {
 public:
@@ -11,8 +18,11 @@ public:
         Slave
     };
 
-    AbstractTransceiver(const Mode &mode): m_mode(mode) {
-
+    AbstractTransceiver(const Mode &mode): m_mode(mode), m_sendSequence(0) {
+        m_handshake.setCallback([this] (const SessionParameters &session) {
+            m_sequenceFilter.reset();
+            sessionNegotiated(session);
+        });
     }
 
     virtual ~AbstractTransceiver() {}
@@ -21,20 +31,91 @@ public:
         return m_mode;
     }
 
+    // What this side offers at connect, set before onStart
+    void setCapabilities(const SessionParameters &capabilities) {
+        m_handshake.setCapabilities(capabilities);
+    }
+
+    const TransportMetrics &metrics() const {
+        return m_metrics;
+    }
+
+    // The slave measures while receiving input, the master only answers
+    LinkQuality &linkQuality() {
+        return m_linkQuality;
+    }
+
+    const LinkQuality &linkQuality() const {
+        return m_linkQuality;
+    }
+
+    // Agreed parameters, only meaningful after sessionNegotiated
+    const SessionParameters &session() const {
+        return m_handshake.session();
+    }
+
 //signals:
-    void error(std::string error);
-    void dataArrived(std::vector<uint8_t> data);
-    void connected();
-    void disconnected(std::string msg);
-    void closeCalled();
+    sigslot::signal<std::string> error;
+    sigslot::signal<std::vector<uint8_t>> dataArrived;
+    // Datagrams with ControlMessage::ControlBit set, never passed to dataArrived. Those the transceiver
+    // handles itself (handshake, ping) come through too, so drivers can treat any of them as a heartbeat
+    sigslot::signal<std::vector<uint8_t>> controlArrived;
+    sigslot::signal<> connected;
+    sigslot::signal<std::string> disconnected;
+    sigslot::signal<> closeCalled;
+    sigslot::signal<SessionParameters> sessionNegotiated;
 
 public:
-    virtual qint64 sendData(const std::vector<uint8_t> &data, const bool &acknowledge = false) = 0;
+    virtual int64_t sendData(const std::vector<uint8_t> &data, const bool &acknowledge = false) = 0;
     virtual void onStart() = 0;
     virtual void onStop() = 0;
+    // Transports that don't live on a Qt event loop expose a descriptor for the host loop to poll
+    virtual int fileDescriptor() const {
+        return -1;
+    }
+    virtual void onReadable() {
+
+    }
 
 protected:
+    // Acknowledged master input goes out as many extra times as the session's redundancy says
+    uint32_t copies(const bool &acknowledge) const {
+        return acknowledge && m_mode == Master && m_handshake.isNegotiated() ? 1 + m_handshake.session().m_redundancy : 1;
+    }
+
+    // Frames sent more than once share a sequence number, so the slave keeps only the first copy
+    const std::vector<uint8_t> &sequenced(const std::vector<uint8_t> &data, const uint32_t &copies, std::vector<uint8_t> &buffer) {
+        if(copies < 2)
+            return data;
+        buffer = SequenceFilter::wrap(m_sendSequence++, data);
+        return buffer;
+    }
+
+    // Slave side, unwraps sequenced input and false for a redundant copy already passed on
+    bool acceptInput(std::vector<uint8_t> &data) {
+        if(m_sequenceFilter.accept(data))
+            return true;
+        m_metrics.m_duplicatesDropped.add();
+        return false;
+    }
+
+    // Master input goes out in the codec the session settled on, whichever layout the caller encoded.
+    // Anything that isn't a float layout GamepadEvent passes through untouched
+    const std::vector<uint8_t> &encoded(const std::vector<uint8_t> &data, std::vector<uint8_t> &buffer) const {
+        if(m_mode != Master || !m_handshake.isNegotiated() || !m_handshake.session().compactCodec())
+            return data;
+        if(data.empty() || data[0] == GamepadEvent::CompactTag || !GamepadEvent::isGamepadEvent(data))
+            return data;
+        buffer = GamepadEvent(data).data(true);
+        return buffer;
+    }
+
     Mode m_mode;
+    SessionHandshake m_handshake;
+    TransportMetrics m_metrics;
+    LinkQuality m_linkQuality;
+    uint16_t m_sendSequence;
+    SequenceFilter m_sequenceFilter;
 };
 
 #endif // ABSTRACTTRANSCEIVER_H
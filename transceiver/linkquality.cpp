@@ -0,0 +1,157 @@
+#include "linkquality.h"
+#include "event/controlmessage.h"
+#include "common/common.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+const uint32_t LinkQuality::PingPeriodms;
+const uint32_t LinkQuality::LossWindow;
+const uint32_t LinkQuality::OffsetWindow;
+const int LinkQuality::LatencyBuckets;
+const uint32_t LinkQuality::LatencyBoundsus[LatencyBuckets] = {
+    500, 1000, 2000, 3000, 4000, 6000, 8000, 12000, 16000, 24000, 32000, 48000, 64000, 96000, 128000, UINT32_MAX
+};
+
+LinkQuality::LinkQuality():
+    m_sequence(0),
+    m_answered(~uint64_t(0)),
+    m_lastRttus(0),
+    m_synchronized(false),
+    m_offsetus(0),
+    m_offsetRttus(UINT32_MAX),
+    m_windowOffsetus(0),
+    m_windowRttus(UINT32_MAX),
+    m_windowSamples(0),
+    m_rttus(0),
+    m_jitterus(0)
+{
+    m_timer.setCallback([this] () { ping(); });
+    m_timer.setInterval(PingPeriodms);
+}
+
+void LinkQuality::setSend(const std::function<void(const std::vector<uint8_t>&)> &send) {
+    m_send = send;
+}
+
+void LinkQuality::start() {
+    // Pings of an earlier session neither count as lost nor get matched
+    m_answered = ~uint64_t(0);
+    m_lastRttus = 0;
+    m_synchronized = false;
+    m_offsetRttus = UINT32_MAX;
+    m_windowRttus = UINT32_MAX;
+    m_windowSamples = 0;
+    m_rttus.store(0, std::memory_order_relaxed);
+    m_jitterus.store(0, std::memory_order_relaxed);
+    ping();
+    m_timer.start();
+}
+
+void LinkQuality::stop() {
+    m_timer.stop();
+    m_synchronized = false;
+}
+
+void LinkQuality::onPing(const std::vector<uint8_t> &data) {
+    ControlMessage pong(data);
+    pong.m_opcode = ControlMessage::Pong;
+    pong.setValue(ControlMessage::EchoTime, monotonicMicros());
+    m_send(pong.data());
+}
+
+void LinkQuality::onPong(const std::vector<uint8_t> &data) {
+    const uint32_t now = monotonicMicros();
+    const ControlMessage pong(data);
+    uint32_t sequence, sent, echoed;
+    if(!pong.value(ControlMessage::Sequence, sequence) || !pong.value(ControlMessage::SenderTime, sent) || !pong.value(ControlMessage::EchoTime, echoed))
+        return;
+    const uint32_t age = m_sequence - sequence;
+    const int64_t rtt = timestampDelta(now, sent);
+    if(age >= LossWindow || (m_answered >> age & 1) || rtt < 0)
+        return;
+    m_answered |= uint64_t(1) << age;
+
+    if(!m_rttus.load(std::memory_order_relaxed)) {
+        m_rttus.store(rtt, std::memory_order_relaxed);
+    } else {
+        const int64_t srtt = m_rttus.load(std::memory_order_relaxed);
+        const int64_t jitter = m_jitterus.load(std::memory_order_relaxed);
+        m_rttus.store(srtt + (rtt - srtt) / 8, std::memory_order_relaxed);
+        m_jitterus.store(jitter + (std::llabs(rtt - m_lastRttus) - jitter) / 16, std::memory_order_relaxed);
+    }
+    m_lastRttus = rtt;
+
+    // The master stamped its echo about half a round trip after we sent, the fastest trip is the least skewed
+    const int32_t offset = timestampDelta(echoed, sent + uint32_t(rtt / 2));
+    if(uint32_t(rtt) < m_windowRttus) {
+        m_windowRttus = rtt;
+        m_windowOffsetus = offset;
+    }
+    if(!m_synchronized || uint32_t(rtt) <= m_offsetRttus) {
+        m_synchronized = true;
+        m_offsetus = offset;
+        m_offsetRttus = rtt;
+    }
+    // Clocks drift and routes change, so the best trip of an older window gives way to the current one's
+    if(++m_windowSamples == OffsetWindow) {
+        m_offsetus = m_windowOffsetus;
+        m_offsetRttus = m_windowRttus;
+        m_windowRttus = UINT32_MAX;
+        m_windowSamples = 0;
+    }
+}
+
+void LinkQuality::onInput(const uint32_t &timestamp, const uint32_t &now) {
+    if(!m_synchronized)
+        return;
+    const int32_t latency = timestampDelta(now, timestamp - m_offsetus);
+    // Within the offset's error a fresh input can look like it came from the future
+    const uint32_t latencyus = latency > 0 ? latency : 0;
+    int bucket = 0;
+    while(latencyus > LatencyBoundsus[bucket])
+        ++bucket;
+    m_latency[bucket].add();
+}
+
+LinkQuality::Snapshot LinkQuality::snapshot() const {
+    Snapshot snapshot;
+    snapshot.pingsSent = m_pingsSent.value();
+    snapshot.pingsLost = m_pingsLost.value();
+    snapshot.rttus = m_rttus.load(std::memory_order_relaxed);
+    snapshot.jitterus = m_jitterus.load(std::memory_order_relaxed);
+    for(int i = 0; i < LatencyBuckets; ++i)
+        snapshot.latency[i] = m_latency[i].value();
+    return snapshot;
+}
+
+uint32_t LinkQuality::percentile(const Snapshot &later, const Snapshot &earlier, const double &fraction) {
+    uint64_t total = 0;
+    for(int i = 0; i < LatencyBuckets; ++i)
+        total += later.latency[i] - earlier.latency[i];
+    if(!total)
+        return 0;
+    const uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(fraction * total)));
+    uint64_t count = 0;
+    for(int i = 0; i < LatencyBuckets; ++i) {
+        count += later.latency[i] - earlier.latency[i];
+        if(count >= rank)
+            return LatencyBoundsus[i];
+    }
+    return LatencyBoundsus[LatencyBuckets - 1];
+}
+
+void LinkQuality::ping() {
+    // Judge the ping leaving the loss window before its slot is reused
+    m_answered <<= 1;
+    if(!(m_answered >> LossWindow & 1))
+        m_pingsLost.add();
+    ++m_sequence;
+    m_pingsSent.add();
+
+    ControlMessage ping(ControlMessage::Ping);
+    ping.setValue(ControlMessage::Sequence, m_sequence);
+    ping.setValue(ControlMessage::SenderTime, monotonicMicros());
+    m_send(ping.data());
+}
@@ -0,0 +1,78 @@
+#ifndef LINKQUALITY_H
+#define LINKQUALITY_H
+
+#include "common/metrics.h"
+#include "common/timerwheel.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Round trip, jitter, loss and input latency of the running session. The slave pings every PingPeriodms and
+// the master echoes each ping with its own clock, which also gives the slave the offset between the two
+// monotonicMicros() clocks so input timestamps can be aged on arrival.
+// Only the thread owning the transceiver writes, snapshot() reads from any thread without a lock
+class LinkQuality {
+public:
+    static const uint32_t PingPeriodms = 250;
+    // A ping still unanswered this many pings later counts as lost, a later pong is ignored
+    static const uint32_t LossWindow = 4;
+    // The clock offset follows the fastest round trip out of this many
+    static const uint32_t OffsetWindow = 32;
+    static const int LatencyBuckets = 16;
+    // Upper bounds of the latency buckets, the last one takes everything slower
+    static const uint32_t LatencyBoundsus[LatencyBuckets];
+
+    struct Snapshot {
+        uint64_t pingsSent;
+        uint64_t pingsLost;
+        // Smoothed like TCP's SRTT, zero until the first pong
+        uint32_t rttus;
+        // Mean deviation of consecutive round trips, as RFC 3550 does for interarrival jitter
+        uint32_t jitterus;
+        // Cumulative counts, an interval's distribution is the difference of two snapshots
+        uint64_t latency[LatencyBuckets];
+    };
+
+    LinkQuality();
+
+    // How pings and pongs go out, set by the transceiver
+    void setSend(const std::function<void(const std::vector<uint8_t>&)> &send);
+
+    // Slave, pings until stopped
+    void start();
+    void stop();
+    // Master, echoes the ping back as a Pong stamped with its clock
+    void onPing(const std::vector<uint8_t> &data);
+    void onPong(const std::vector<uint8_t> &data);
+    // Input stamped with the master's clock arrived at local time now, ignored until the first pong
+    void onInput(const uint32_t &timestamp, const uint32_t &now);
+
+    Snapshot snapshot() const;
+    // Upper bound of the bucket the given fraction of the samples between two snapshots falls in, 0 without samples
+    static uint32_t percentile(const Snapshot &later, const Snapshot &earlier, const double &fraction);
+
+private:
+    void ping();
+
+    TimerWheel::Timer m_timer;
+    std::function<void(const std::vector<uint8_t>&)> m_send;
+    uint32_t m_sequence;
+    // Bit i set once ping m_sequence - i has been answered
+    uint64_t m_answered;
+    int64_t m_lastRttus;
+    // Master clock minus ours, taken from the fastest recent round trip
+    bool m_synchronized;
+    int32_t m_offsetus;
+    uint32_t m_offsetRttus;
+    int32_t m_windowOffsetus;
+    uint32_t m_windowRttus;
+    uint32_t m_windowSamples;
+
+    Metrics::Counter m_pingsSent;
+    Metrics::Counter m_pingsLost;
+    Metrics::Counter m_latency[LatencyBuckets];
+    std::atomic<uint32_t> m_rttus;
+    std::atomic<uint32_t> m_jitterus;
+};
+
+#endif // LINKQUALITY_H
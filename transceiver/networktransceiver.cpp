@@ -1,9 +1,10 @@
 #include "networktransceiver.h"
+#include "common/trace.h"
+#include "event/controlmessage.h"
 #include <QThreadPool>
 #include <QWidget>
 #include <QNetworkInterface>
 #include <QNetworkDatagram>
-#include <QDataStream>
 
 unsigned int NetworkTransceiver::m_datagramId = 0;
 
@@ -24,19 +25,43 @@ NetworkTransceiver::NetworkTransceiver(const Mode &mode, QObject *parent):
     // Initilize udp socket and make connections
     m_udpSocket = new QUdpSocket();
     connect(m_udpSocket, &QUdpSocket::readyRead, this, &NetworkTransceiver::onReadyRead);
+
+    // Straight to the peer, the slave answers the first offer before its state has switched
+    const auto send = [this] (const std::vector<uint8_t> &data) {
+        const QByteArray bytes(reinterpret_cast<const char*>(data.data()), data.size());
+        if(m_mode == Mode::Master)
+            m_udpSocket->write(bytes);
+        else
+            m_udpSocket->writeDatagram(bytes, m_masterHost, m_port);
+    };
+    m_handshake.setSend(send);
+    m_linkQuality.setSend(send);
+    m_metrics.publish(m_mode == Mode::Master ? "transport=\"network\",role=\"master\"" : "transport=\"network\",role=\"slave\"");
 }
 
 NetworkTransceiver::~NetworkTransceiver() {
     delete m_state;
 }
 
-qint64 NetworkTransceiver::sendData(const QByteArray &data, const bool &acknowledge) {
-    return m_state->sendData(data, acknowledge);
+int64_t NetworkTransceiver::sendData(const std::vector<uint8_t> &data, const bool &acknowledge) {
+    TRACE_SCOPE("send");
+    std::vector<uint8_t> buffer, sequenceBuffer;
+    const std::vector<uint8_t> &frame = sequenced(encoded(data, buffer), copies(acknowledge), sequenceBuffer);
+    const qint64 sent = m_state->sendData(QByteArray(reinterpret_cast<const char*>(frame.data()), frame.size()), acknowledge);
+    if(sent < 0) {
+        m_metrics.m_sendFailures.add();
+    } else {
+        m_metrics.m_packetsSent.add();
+        m_metrics.m_bytesSent.add(sent);
+    }
+    return sent;
 }
 
 void NetworkTransceiver::onStart() {
     AbstractState *nextState = m_state->start();
     if(nextState) {
+        m_metrics.m_stateTransitions.add();
+        TRACE_INSTANT("state transition");
         delete m_state;
         m_state = nextState;
     }
@@ -45,19 +70,40 @@ void NetworkTransceiver::onStart() {
 void NetworkTransceiver::onStop() {
     AbstractState *nextState = m_state->stop();
     if(nextState) {
+        m_metrics.m_stateTransitions.add();
+        TRACE_INSTANT("state transition");
         delete m_state;
         m_state = nextState;
     }
 }
 
 void NetworkTransceiver::onReadyRead() {
+    TRACE_SCOPE("receive");
+    const qint64 size = m_udpSocket->pendingDatagramSize();
+    if(size >= 0) {
+        m_metrics.m_packetsReceived.add();
+        m_metrics.m_bytesReceived.add(size);
+    }
     AbstractState *nextState = m_state->onReadyRead();
     if(nextState) {
+        m_metrics.m_stateTransitions.add();
+        TRACE_INSTANT("state transition");
         delete m_state;
         m_state = nextState;
     }
 }
 
+void NetworkTransceiver::onControl(const QByteArray &data) {
+    const std::vector<uint8_t> bytes(data.begin(), data.end());
+    if(bytes[0] == ControlMessage::Capabilities)
+        m_handshake.onCapabilities(bytes);
+    else if(bytes[0] == ControlMessage::Ping)
+        m_linkQuality.onPing(bytes);
+    else if(bytes[0] == ControlMessage::Pong)
+        m_linkQuality.onPong(bytes);
+    controlArrived(bytes);
+}
+
 void NetworkTransceiver::setSlaveHost(const QHostAddress &slaveHost)
 {
     m_slaveHost = slaveHost;
@@ -82,14 +128,14 @@ NetworkTransceiver::StateInitMaster::~StateInitMaster() {
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateInitMaster::start() {
 
     if(m_transceiver->m_selectedInterface.isNull()) {
-        m_transceiver->emit error(tr("Error, no interface selected!"));
+        m_transceiver->emit error(tr("Error, no interface selected!").toStdString());
         return nullptr;
     }
 
     m_transceiver->m_udpSocket->close();
     if(!m_transceiver->m_udpSocket->bind(QHostAddress::Any, m_transceiver->m_port)) {
 //    if(!m_transceiver->m_udpSocket->bind(m_transceiver->m_selectedInterface, m_transceiver->m_port)) {
-        m_transceiver->emit error(tr("Error binding socket to host: ") + m_transceiver->m_selectedInterface.toString() + tr(", port: ") + QString::number(m_transceiver->m_port));
+        m_transceiver->emit error((tr("Error binding socket to host: ") + m_transceiver->m_selectedInterface.toString() + tr(", port: ") + QString::number(m_transceiver->m_port)).toStdString());
         return nullptr;
     }
 
@@ -116,7 +162,7 @@ NetworkTransceiver::StateListen::~StateListen() {
 
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateListen::start() {
     if(m_transceiver->m_slaveHost.isNull()) {
-        m_transceiver->emit error(tr("Error, no target device selected!"));
+        m_transceiver->emit error(tr("Error, no target device selected!").toStdString());
         return nullptr;
     }
     else {
@@ -146,9 +192,11 @@ NetworkTransceiver::StateSendInput::StateSendInput(NetworkTransceiver *transceiv
     m_transceiver->emit stateChanged(State::SendInput);
     m_transceiver->connected();
     m_transceiver->m_udpSocket->connectToHost(m_transceiver->m_slaveHost, m_transceiver->m_port);
+    m_transceiver->m_handshake.offer();
 }
 
 NetworkTransceiver::StateSendInput::~StateSendInput() {
+    m_transceiver->m_handshake.stop();
     m_transceiver->m_udpSocket->disconnectFromHost();
     m_transceiver->disconnected("Disconnected by user");
 }
@@ -158,19 +206,21 @@ NetworkTransceiver::AbstractState *NetworkTransceiver::StateSendInput::start() {
 }
 
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateSendInput::stop() {
+    // Lets the slave go back to broadcasting now instead of after its keepalive
+    m_transceiver->m_udpSocket->write(QByteArray(1, char(ControlMessage::Quit)));
     return new StateInitMaster(m_transceiver);
 }
 
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateSendInput::onReadyRead() {
     QNetworkDatagram datagram = m_transceiver->m_udpSocket->receiveDatagram();
-    QByteArray data = datagram.data();
-    QDataStream in(&data, QIODevice::ReadOnly);
-    QString str;
-    in << str;
-    if(str == "quit") {
-        return new StateListen(m_transceiver);
-    } else
+    const QByteArray data = datagram.data();
+    // Only control messages come back from the slave, anything else is dropped unparsed
+    if(data.isEmpty() || !(uint8_t(data[0]) & ControlMessage::ControlBit))
         return nullptr;
+    if(uint8_t(data[0]) == ControlMessage::Quit)
+        return new StateListen(m_transceiver);
+    m_transceiver->onControl(data);
+    return nullptr;
 }
 
 qint64 NetworkTransceiver::StateSendInput::sendData(const QByteArray &data, const bool &acknowledge) {
@@ -179,7 +229,10 @@ qint64 NetworkTransceiver::StateSendInput::sendData(const QByteArray &data, cons
 //    datagram.setSender(m_transceiver->m_selectedInterface, m_transceiver->m_port);
 //    datagram.setDestination(m_transceiver->m_slaveHost, m_transceiver->m_port);
 //    m_transceiver->m_udpSocket->connectToHost(m_transceiver->m_slaveHost, m_transceiver->m_port);
-    return m_transceiver->m_udpSocket->write(data);
+    qint64 sent = -1;
+    for(uint32_t i = m_transceiver->copies(acknowledge); i > 0; --i)
+        sent = m_transceiver->m_udpSocket->write(data);
+    return sent;
 //    return m_transceiver->m_udpSocket->writeDatagram(datagram);
 }
 
@@ -194,13 +247,13 @@ NetworkTransceiver::StateInitSlave::~StateInitSlave() {
 
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateInitSlave::start() {
     if(m_transceiver->m_selectedInterface.isNull()) {
-        m_transceiver->emit error(tr("Error, no interface selected!"));
+        m_transceiver->emit error(tr("Error, no interface selected!").toStdString());
         return nullptr;
     }
 
     m_transceiver->m_udpSocket->close();
     if(!m_transceiver->m_udpSocket->bind(m_transceiver->m_selectedInterface, m_transceiver->m_port)) {
-        m_transceiver->emit error(tr("Error binding socket to host: ") + m_transceiver->m_selectedInterface.toString() + tr(", port: ") + QString::number(m_transceiver->m_port));
+        m_transceiver->emit error((tr("Error binding socket to host: ") + m_transceiver->m_selectedInterface.toString() + tr(", port: ") + QString::number(m_transceiver->m_port)).toStdString());
         return nullptr;
     }
 
@@ -222,7 +275,7 @@ NetworkTransceiver::StateBroadcast::StateBroadcast(NetworkTransceiver *transceiv
 
     QNetworkDatagram datagram;
     datagram.setDestination(QHostAddress::Broadcast, m_transceiver->m_port);
-    connect(&m_timer, &QTimer::timeout, [this, datagram] () {
+    m_timer.setCallback([this, datagram] () {
         m_transceiver->m_udpSocket->writeDatagram(datagram);
     });
 
@@ -245,7 +298,12 @@ NetworkTransceiver::AbstractState *NetworkTransceiver::StateBroadcast::stop() {
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateBroadcast::onReadyRead() {
     QNetworkDatagram datagram = m_transceiver->m_udpSocket->receiveDatagram();
     m_transceiver->m_masterHost = datagram.senderAddress();
-    return new StateReceiveInput(m_transceiver);
+    AbstractState *nextState = new StateReceiveInput(m_transceiver);
+    // The master opens with its offer, answer it now rather than on its retransmit
+    const QByteArray data = datagram.data();
+    if(!data.isEmpty() && uint8_t(data[0]) == ControlMessage::Capabilities)
+        m_transceiver->onControl(data);
+    return nextState;
 }
 
 qint64 NetworkTransceiver::StateBroadcast::sendData(const QByteArray &data, const bool &acknowledge) {
@@ -257,11 +315,18 @@ NetworkTransceiver::StateReceiveInput::StateReceiveInput(NetworkTransceiver *tra
     m_transceiver->emit stateChanged(State::ReceiveInput);
     m_transceiver->emit connected();
 
-    connect(&m_timer, &QTimer::timeout, m_transceiver, &NetworkTransceiver::onStop);
+    // Fires into onStop, which deletes this state and the timer with it, the wheel allows that
+    m_timer.setCallback([this] () {
+        m_transceiver->onStop();
+    });
     m_timer.start(m_timeoutms);
+    m_transceiver->m_handshake.await();
+    m_transceiver->m_linkQuality.start();
 }
 
 NetworkTransceiver::StateReceiveInput::~StateReceiveInput() {
+    m_transceiver->m_handshake.stop();
+    m_transceiver->m_linkQuality.stop();
     m_transceiver->emit disconnected("");
 }
 
@@ -270,13 +335,9 @@ NetworkTransceiver::AbstractState *NetworkTransceiver::StateReceiveInput::start(
 }
 
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateReceiveInput::stop() {
-    QByteArray data;
-    QDataStream out(&data, QIODevice::WriteOnly);
-    out << QString("quit");
-
     QNetworkDatagram datagram;
     datagram.setDestination(m_transceiver->m_masterHost, m_transceiver->m_port);
-    datagram.setData(data);
+    datagram.setData(QByteArray(1, char(ControlMessage::Quit)));
     m_transceiver->m_udpSocket->writeDatagram(datagram);
 
     return new StateBroadcast(m_transceiver);
@@ -285,12 +346,24 @@ NetworkTransceiver::AbstractState *NetworkTransceiver::StateReceiveInput::stop()
 NetworkTransceiver::AbstractState *NetworkTransceiver::StateReceiveInput::onReadyRead() {
     m_timer.start(m_timeoutms);
     QNetworkDatagram datagram = m_transceiver->m_udpSocket->receiveDatagram();
-    m_transceiver->dataArrived(datagram.data());
+    const QByteArray data = datagram.data();
+    // One bit decides, input frames go out without being looked at any further
+    if(!data.isEmpty() && uint8_t(data[0]) & ControlMessage::ControlBit) {
+        if(uint8_t(data[0]) == ControlMessage::Quit)
+            return new StateBroadcast(m_transceiver);
+        m_transceiver->onControl(data);
+        return nullptr;
+    }
+    std::vector<uint8_t> input(data.begin(), data.end());
+    if(m_transceiver->acceptInput(input))
+        m_transceiver->dataArrived(input);
+    return nullptr;
 }
 
-qint64 NetworkTransceiver::StateReceiveInput::sendData(const QByteArray &data, const bool &acknowledge) {
+qint64 NetworkTransceiver::StateReceiveInput::sendData(const QByteArray &data, const bool &/*acknowledge*/) {
     QNetworkDatagram datagram;
     datagram.setDestination(m_transceiver->m_masterHost, m_transceiver->m_port);
     datagram.setData(data);
+    // Redundancy is for master input, feedback goes out once
     return m_transceiver->m_udpSocket->writeDatagram(datagram);
 }
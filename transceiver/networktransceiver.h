@@ -2,6 +2,7 @@
 #define NETWORKTRANSCEIVER_H
 
 #include "transceiver/abstracttransceiver.h"
+#include "common/timerwheel.h"
 //#include <QUdpSocket>
 //#include <QTimer>
 //#include <QListWidgetItem>
@@ -33,7 +34,7 @@ public:
     NetworkTransceiver(const Mode &mode, QObject *parent = nullptr);
     ~NetworkTransceiver();
 
-    qint64 sendData(const QByteArray &data, const bool &acknowledge = false) override;
+    int64_t sendData(const std::vector<uint8_t> &data, const bool &acknowledge = false) override;
 
     void setSelectedInterface(const QHostAddress &selectedInterface);
 
@@ -53,6 +54,8 @@ private slots:
     void onReadyRead();
 
 private:
+    // Capabilities go to the handshake, Ping and Pong to the link quality, then all of them out through controlArrived
+    void onControl(const QByteArray &data);
 
     AbstractState *m_state;
     QUdpSocket *m_udpSocket;
@@ -116,7 +119,7 @@ public:
 
     AbstractState *start() override;
     AbstractState *stop() override;
-    AbstractState *onReadyRead() override; // When the slave informs it has quit receiving input go back to previous state and display an info message
+    AbstractState *onReadyRead() override; // Control from the slave, on quit go back to previous state and display an info message
     qint64 sendData(const QByteArray &data, const bool &acknowledge = false) override;
 };
 
@@ -143,7 +146,7 @@ public:
 
 private:
     int m_pollPeriodMS;
-    QTimer m_timer;
+    TimerWheel::Timer m_timer;
 };
 
 class NetworkTransceiver::StateReceiveInput: public NetworkTransceiver::AbstractState {
@@ -153,11 +156,11 @@ public:
 
     AbstractState *start() override;
     AbstractState *stop() override;
-    AbstractState *onReadyRead() override; // Receive data and emit data arrived signal
+    AbstractState *onReadyRead() override; // Receive data and emit data or control arrived signal, on quit go back to broadcast
     qint64 sendData(const QByteArray &data, const bool &acknowledge = false) override;
 
 private:
-    QTimer m_timer;
+    TimerWheel::Timer m_timer;
     int m_timeoutms;
 };
 
@@ -0,0 +1,51 @@
+#include "sequencefilter.h"
+
+const uint8_t SequenceFilter::Tag;
+const size_t SequenceFilter::HeaderSize;
+const uint32_t SequenceFilter::Window;
+
+std::vector<uint8_t> SequenceFilter::wrap(const uint16_t &sequence, const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> frame;
+    frame.reserve(HeaderSize + data.size());
+    frame.push_back(Tag);
+    frame.push_back(sequence >> 8);
+    frame.push_back(sequence & 0xff);
+    frame.insert(frame.end(), data.begin(), data.end());
+    return frame;
+}
+
+bool SequenceFilter::isSequenced(const std::vector<uint8_t> &data) {
+    return data.size() > HeaderSize && data[0] == Tag;
+}
+
+SequenceFilter::SequenceFilter() {
+    reset();
+}
+
+void SequenceFilter::reset() {
+    m_started = false;
+    m_newest = 0;
+    m_seen = 0;
+}
+
+bool SequenceFilter::accept(std::vector<uint8_t> &data) {
+    if(!isSequenced(data))
+        return data.empty() || data[0] != Tag;
+    const uint16_t sequence = uint16_t(data[1]) << 8 | data[2];
+
+    // Serial number arithmetic, the sequence wraps after 65536 frames
+    const int16_t ahead = m_started ? int16_t(sequence - m_newest) : 1;
+    if(ahead > 0) {
+        m_seen = uint32_t(ahead) < Window ? m_seen << ahead : 0;
+        m_seen |= 1;
+        m_newest = sequence;
+        m_started = true;
+    } else {
+        const uint32_t age = -int32_t(ahead);
+        if(age >= Window || (m_seen >> age & 1))
+            return false;
+        m_seen |= uint64_t(1) << age;
+    }
+    data.erase(data.begin(), data.begin() + HeaderSize);
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef SEQUENCEFILTER_H
+#define SEQUENCEFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Redundant input goes out wrapped: Tag, a big endian uint16 sequence, then the frame. Every copy of a
+// frame carries the same sequence, so the receiver can pass on the first and drop the rest. Without it a
+// duplicate press reordered behind its release would press the button again and leave it held
+class SequenceFilter {
+public:
+    // Can't start a GamepadEvent in either layout, a motion packet nor a control message
+    static const uint8_t Tag = 0x21;
+    static const size_t HeaderSize = 3;
+    // Sequences this far behind the newest can't be told from ones already seen and are dropped
+    static const uint32_t Window = 64;
+
+    static std::vector<uint8_t> wrap(const uint16_t &sequence, const std::vector<uint8_t> &data);
+    static bool isSequenced(const std::vector<uint8_t> &data);
+
+    SequenceFilter();
+
+    // Forgets the sequences seen, for a new session
+    void reset();
+    // Unwraps a sequenced frame in place, false when it's a copy already passed on or too old to tell.
+    // Anything not sequenced passes untouched
+    bool accept(std::vector<uint8_t> &data);
+
+private:
+    bool m_started;
+    uint16_t m_newest;
+    // Bit n set when m_newest - n has been passed on
+    uint64_t m_seen;
+};
+
+#endif // SEQUENCEFILTER_H
@@ -0,0 +1,82 @@
+#include "sessionhandshake.h"
+
+const uint32_t SessionHandshake::RetransmitPeriodms;
+const int SessionHandshake::MaxAttempts;
+
+SessionHandshake::SessionHandshake(): m_offering(false), m_negotiated(false), m_attempts(0) {
+    m_timer.setCallback([this] () { onTimeout(); });
+}
+
+void SessionHandshake::setCapabilities(const SessionParameters &capabilities) {
+    m_capabilities = capabilities;
+}
+
+const SessionParameters &SessionHandshake::capabilities() const {
+    return m_capabilities;
+}
+
+void SessionHandshake::setSend(const std::function<void(const std::vector<uint8_t>&)> &send) {
+    m_send = send;
+}
+
+void SessionHandshake::setCallback(const std::function<void(const SessionParameters&)> &callback) {
+    m_callback = callback;
+}
+
+void SessionHandshake::offer() {
+    m_offering = true;
+    m_negotiated = false;
+    m_attempts = 1;
+    m_send(m_capabilities.message().data());
+    m_timer.setSingleShot(false);
+    m_timer.start(RetransmitPeriodms);
+}
+
+void SessionHandshake::await() {
+    m_offering = false;
+    m_negotiated = false;
+    m_timer.setSingleShot(true);
+    m_timer.start(RetransmitPeriodms * MaxAttempts);
+}
+
+void SessionHandshake::stop() {
+    m_timer.stop();
+    m_negotiated = false;
+}
+
+void SessionHandshake::onCapabilities(const std::vector<uint8_t> &data) {
+    const SessionParameters peer{ControlMessage(data)};
+    // Answer every offer, the master retransmits until one of the answers gets through
+    if(!m_offering)
+        m_send(m_capabilities.message().data());
+    else if(m_negotiated)
+        return;
+    settle(peer);
+}
+
+bool SessionHandshake::isNegotiated() const {
+    return m_negotiated;
+}
+
+const SessionParameters &SessionHandshake::session() const {
+    return m_session;
+}
+
+void SessionHandshake::settle(const SessionParameters &peer) {
+    m_timer.stop();
+    const SessionParameters session = SessionParameters::negotiate(m_capabilities, peer);
+    const bool changed = !m_negotiated || !(session == m_session);
+    m_session = session;
+    m_negotiated = true;
+    if(changed && m_callback)
+        m_callback(m_session);
+}
+
+void SessionHandshake::onTimeout() {
+    if(m_offering && m_attempts < MaxAttempts) {
+        ++m_attempts;
+        m_send(m_capabilities.message().data());
+        return;
+    }
+    settle(SessionParameters::baseline());
+}
@@ -0,0 +1,49 @@
+#ifndef SESSIONHANDSHAKE_H
+#define SESSIONHANDSHAKE_H
+
+#include "event/sessionparameters.h"
+#include "common/timerwheel.h"
+#include <functional>
+
+// Connect-time Capabilities exchange. The master offers and retransmits until the slave answers with its own
+// offer, the slave answers every offer so a lost answer is covered by the next retransmit. Both then run
+// negotiate() on the same two offers. A peer that never answers is assumed to be at the baseline
+class SessionHandshake {
+public:
+    static const uint32_t RetransmitPeriodms = 100;
+    static const int MaxAttempts = 10;
+
+    SessionHandshake();
+
+    void setCapabilities(const SessionParameters &capabilities);
+    const SessionParameters &capabilities() const;
+    // How offers and answers go out, set by the transceiver
+    void setSend(const std::function<void(const std::vector<uint8_t>&)> &send);
+    // Called once the session is settled, and again if a later offer changes it
+    void setCallback(const std::function<void(const SessionParameters&)> &callback);
+
+    // Master, sends the offer and keeps retransmitting until answered
+    void offer();
+    // Slave, waits for an offer, falls back to the baseline once the master would have given up
+    void await();
+    void stop();
+    void onCapabilities(const std::vector<uint8_t> &data);
+
+    bool isNegotiated() const;
+    const SessionParameters &session() const;
+
+private:
+    void settle(const SessionParameters &peer);
+    void onTimeout();
+
+    SessionParameters m_capabilities;
+    SessionParameters m_session;
+    bool m_offering;
+    bool m_negotiated;
+    int m_attempts;
+    TimerWheel::Timer m_timer;
+    std::function<void(const std::vector<uint8_t>&)> m_send;
+    std::function<void(const SessionParameters&)> m_callback;
+};
+
+#endif // SESSIONHANDSHAKE_H
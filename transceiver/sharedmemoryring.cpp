@@ -0,0 +1,201 @@
+#include "sharedmemoryring.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+
+// Producer and consumer indices on their own cache lines, they only ever grow and wrap through the mask
+struct SharedMemoryRing::Header {
+    uint32_t magic;
+    uint32_t capacity;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint32_t> armed;
+};
+
+const uint32_t SharedMemoryRing::DefaultCapacity;
+const uint32_t SharedMemoryRing::Magic;
+const uint32_t SharedMemoryRing::WrapMarker;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indices must be lock free to be shared between processes");
+
+static inline uint32_t frameSize(const uint32_t &size) {
+    return (sizeof(uint32_t) + size + 3) & ~uint32_t(3);
+}
+
+SharedMemoryRing::SharedMemoryRing(): m_header(nullptr), m_data(nullptr), m_capacity(0), m_mappedSize(0), m_memoryFileDescriptor(-1), m_eventFileDescriptor(-1) {
+}
+
+SharedMemoryRing::~SharedMemoryRing() {
+    detach();
+}
+
+bool SharedMemoryRing::create(const uint32_t &capacity) {
+    detach();
+    m_capacity = 64;
+    while(m_capacity < capacity)
+        m_capacity <<= 1;
+
+    const int memoryFileDescriptor = memfd_create("openrudder-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(memoryFileDescriptor < 0)
+        return false;
+    if(ftruncate(memoryFileDescriptor, sizeof(Header) + m_capacity) < 0) {
+        close(memoryFileDescriptor);
+        return false;
+    }
+    // The producer can't shrink the memory under us and fault the consumer with SIGBUS
+    fcntl(memoryFileDescriptor, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    m_eventFileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(m_eventFileDescriptor < 0 || !map(memoryFileDescriptor, true)) {
+        close(memoryFileDescriptor);
+        detach();
+        return false;
+    }
+    return true;
+}
+
+bool SharedMemoryRing::attach(const int &memoryFileDescriptor, const int &eventFileDescriptor) {
+    detach();
+    m_eventFileDescriptor = eventFileDescriptor;
+    if(!map(memoryFileDescriptor, false)) {
+        close(memoryFileDescriptor);
+        detach();
+        return false;
+    }
+    return true;
+}
+
+bool SharedMemoryRing::map(const int &memoryFileDescriptor, const bool &initialize) {
+    struct stat status;
+    if(fstat(memoryFileDescriptor, &status) < 0 || size_t(status.st_size) <= sizeof(Header))
+        return false;
+    void *memory = mmap(nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFileDescriptor, 0);
+    if(memory == MAP_FAILED)
+        return false;
+    Header *header = static_cast<Header*>(memory);
+
+    if(initialize) {
+        header->magic = Magic;
+        header->capacity = m_capacity;
+        header->head.store(0, std::memory_order_relaxed);
+        header->tail.store(0, std::memory_order_relaxed);
+        header->armed.store(1, std::memory_order_release);
+    } else {
+        // Trust the header only as far as the mapping goes
+        const uint32_t capacity = header->capacity;
+        if(header->magic != Magic || capacity == 0 || (capacity & (capacity - 1)) || sizeof(Header) + capacity > size_t(status.st_size)) {
+            munmap(memory, status.st_size);
+            return false;
+        }
+        m_capacity = capacity;
+    }
+    m_memoryFileDescriptor = memoryFileDescriptor;
+    m_mappedSize = status.st_size;
+    m_header = header;
+    m_data = static_cast<uint8_t*>(memory) + sizeof(Header);
+    return true;
+}
+
+void SharedMemoryRing::detach() {
+    if(m_header)
+        munmap(m_header, m_mappedSize);
+    if(m_memoryFileDescriptor >= 0)
+        close(m_memoryFileDescriptor);
+    if(m_eventFileDescriptor >= 0)
+        close(m_eventFileDescriptor);
+    m_header = nullptr;
+    m_data = nullptr;
+    m_capacity = 0;
+    m_mappedSize = 0;
+    m_memoryFileDescriptor = -1;
+    m_eventFileDescriptor = -1;
+}
+
+bool SharedMemoryRing::isAttached() const {
+    return m_header != nullptr;
+}
+
+int SharedMemoryRing::memoryFileDescriptor() const {
+    return m_memoryFileDescriptor;
+}
+
+int SharedMemoryRing::eventFileDescriptor() const {
+    return m_eventFileDescriptor;
+}
+
+bool SharedMemoryRing::push(const uint8_t *data, const uint32_t &size) {
+    if(!m_header)
+        return false;
+    const uint32_t needed = frameSize(size);
+    if(needed > m_capacity / 2)
+        return false;
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+    uint32_t offset = head & (m_capacity - 1);
+    // Frames never straddle the end, the rest of the lap is skipped instead
+    const uint32_t skip = offset + needed > m_capacity ? m_capacity - offset : 0;
+    if(m_capacity - (head - tail) < skip + needed)
+        return false;
+    if(skip) {
+        memcpy(m_data + offset, &WrapMarker, sizeof(WrapMarker));
+        head += skip;
+        offset = 0;
+    }
+    memcpy(m_data + offset, &size, sizeof(size));
+    memcpy(m_data + offset + sizeof(size), data, size);
+
+    // Publishing head and reading armed pair with arm() storing armed and reading head,
+    // both sequentially consistent so at least one side sees the other and no wakeup is lost
+    m_header->head.store(head + needed, std::memory_order_seq_cst);
+    if(m_header->armed.load(std::memory_order_seq_cst) && m_header->armed.exchange(0, std::memory_order_seq_cst)) {
+        const uint64_t one = 1;
+        if(write(m_eventFileDescriptor, &one, sizeof(one)) < 0) {}
+    }
+    return true;
+}
+
+bool SharedMemoryRing::pop(std::vector<uint8_t> &frame) {
+    if(!m_header)
+        return false;
+    uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    const uint64_t head = m_header->head.load(std::memory_order_acquire);
+    while(tail != head) {
+        const uint32_t offset = tail & (m_capacity - 1);
+        uint32_t size;
+        memcpy(&size, m_data + offset, sizeof(size));
+        if(size == WrapMarker) {
+            tail += m_capacity - offset;
+            continue;
+        }
+        const uint32_t needed = frameSize(size);
+        // A producer writing garbage loses what it queued, it can't make us read out of bounds
+        if(size > m_capacity || offset + needed > m_capacity || head - tail < needed) {
+            m_header->tail.store(head, std::memory_order_release);
+            return false;
+        }
+        frame.assign(m_data + offset + sizeof(size), m_data + offset + sizeof(size) + size);
+        m_header->tail.store(tail + needed, std::memory_order_release);
+        return true;
+    }
+    m_header->tail.store(tail, std::memory_order_release);
+    return false;
+}
+
+bool SharedMemoryRing::arm() {
+    if(!m_header)
+        return true;
+    m_header->armed.store(1, std::memory_order_seq_cst);
+    if(m_header->head.load(std::memory_order_seq_cst) != m_header->tail.load(std::memory_order_relaxed)) {
+        m_header->armed.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void SharedMemoryRing::clearWakeup() {
+    uint64_t count;
+    if(read(m_eventFileDescriptor, &count, sizeof(count)) < 0) {}
+}
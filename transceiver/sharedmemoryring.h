@@ -0,0 +1,55 @@
+#ifndef SHAREDMEMORYRING_H
+#define SHAREDMEMORYRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Single producer single consumer ring of length-prefixed frames in a memfd, shared between processes.
+// The consumer sleeps on an eventfd, the producer only writes it when the consumer armed the wakeup
+// before going to sleep, so a busy stream costs no syscalls at all
+class SharedMemoryRing {
+public:
+    static const uint32_t DefaultCapacity = 1 << 16;
+
+    SharedMemoryRing();
+    ~SharedMemoryRing();
+    SharedMemoryRing(const SharedMemoryRing &) = delete;
+    SharedMemoryRing &operator=(const SharedMemoryRing &) = delete;
+
+    // Consumer side, creates the memory and the eventfd. Capacity is rounded up to a power of two
+    bool create(const uint32_t &capacity = DefaultCapacity);
+    // Producer side, maps descriptors received from the consumer and takes ownership of them
+    bool attach(const int &memoryFileDescriptor, const int &eventFileDescriptor);
+    void detach();
+    bool isAttached() const;
+
+    int memoryFileDescriptor() const;
+    int eventFileDescriptor() const;
+
+    // Producer, false when the frame doesn't fit, nothing is written then
+    bool push(const uint8_t *data, const uint32_t &size);
+    // Consumer, false when the ring is empty
+    bool pop(std::vector<uint8_t> &frame);
+    // Consumer, call before sleeping on the eventfd. False if frames arrived meanwhile, pop those first
+    bool arm();
+    // Consumer, resets the eventfd after a wakeup
+    void clearWakeup();
+
+private:
+    struct Header;
+    static const uint32_t Magic = 0x4f52534d;
+    static const uint32_t WrapMarker = 0xffffffff;
+
+    bool map(const int &memoryFileDescriptor, const bool &initialize);
+
+    Header *m_header;
+    uint8_t *m_data;
+    uint32_t m_capacity;
+    size_t m_mappedSize;
+    int m_memoryFileDescriptor;
+    int m_eventFileDescriptor;
+};
+
+#endif // SHAREDMEMORYRING_H
@@ -0,0 +1,370 @@
+#include "sharedmemorytransceiver.h"
+#include "event/controlmessage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+// Sent along with the descriptors so a stray client on the path can't be mistaken for a driver
+static const char Greeting[] = "openrudder-ring-1";
+
+static bool socketAddress(const std::string &path, struct sockaddr_un &address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path))
+        return false;
+    memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+static bool sendDescriptors(const int &socketFileDescriptor, const int &first, const int &second) {
+    struct iovec io;
+    io.iov_base = (void*)Greeting;
+    io.iov_len = sizeof(Greeting);
+    union {
+        char buffer[CMSG_SPACE(2 * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    const int descriptors[2] = {first, second};
+    memcpy(CMSG_DATA(header), descriptors, sizeof(descriptors));
+    return sendmsg(socketFileDescriptor, &message, MSG_NOSIGNAL) == sizeof(Greeting);
+}
+
+// Descriptors that came with anything but a greeting are closed and reported as missing
+static bool receiveDescriptors(const int &socketFileDescriptor, int &first, int &second) {
+    char greeting[sizeof(Greeting)];
+    struct iovec io;
+    io.iov_base = greeting;
+    io.iov_len = sizeof(greeting);
+    union {
+        char buffer[CMSG_SPACE(2 * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    const ssize_t size = recvmsg(socketFileDescriptor, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if(size <= 0)
+        return false;
+
+    first = second = -1;
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    if(header && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS && header->cmsg_len == CMSG_LEN(2 * sizeof(int))) {
+        int descriptors[2];
+        memcpy(descriptors, CMSG_DATA(header), sizeof(descriptors));
+        first = descriptors[0];
+        second = descriptors[1];
+    }
+    if(size != sizeof(Greeting) || memcmp(greeting, Greeting, sizeof(Greeting)) != 0 || first < 0) {
+        if(first >= 0)
+            close(first);
+        if(second >= 0)
+            close(second);
+        return false;
+    }
+    return true;
+}
+
+SharedMemoryTransceiver::SharedMemoryTransceiver(const Mode &mode, const std::string &path):
+    AbstractTransceiver(mode),
+    m_pollFileDescriptor(-1),
+    m_listenFileDescriptor(-1),
+    m_connectionFileDescriptor(-1),
+    m_state(Idle),
+    m_path(path)
+{
+    const auto send = [this] (const std::vector<uint8_t> &data) {
+        sendData(data);
+    };
+    m_handshake.setSend(send);
+    m_linkQuality.setSend(send);
+    m_metrics.publish(mode == Mode::Master ? "transport=\"shm\",role=\"master\"" : "transport=\"shm\",role=\"slave\"");
+}
+
+SharedMemoryTransceiver::~SharedMemoryTransceiver() {
+    if(m_connectionFileDescriptor >= 0)
+        close(m_connectionFileDescriptor);
+    if(m_listenFileDescriptor >= 0) {
+        close(m_listenFileDescriptor);
+        unlink(m_path.c_str());
+    }
+    if(m_pollFileDescriptor >= 0)
+        close(m_pollFileDescriptor);
+}
+
+std::string SharedMemoryTransceiver::defaultPath() {
+    const char *runtimeDirectory = getenv("XDG_RUNTIME_DIR");
+    if(runtimeDirectory && runtimeDirectory[0])
+        return std::string(runtimeDirectory) + "/openrudder.sock";
+    return "/tmp/openrudder-" + std::to_string(getuid()) + ".sock";
+}
+
+int64_t SharedMemoryTransceiver::sendData(const std::vector<uint8_t> &data, const bool &/*acknowledge*/) {
+    int64_t sent = -1;
+    std::vector<uint8_t> buffer;
+    const std::vector<uint8_t> &frame = encoded(data, buffer);
+    if(m_state == Connected && m_mode == Master)
+        sent = m_ring.push(frame.data(), frame.size()) ? int64_t(frame.size()) : -1;
+    else if(m_state == Connected)
+        sent = send(m_connectionFileDescriptor, data.data(), data.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(sent < 0) {
+        m_metrics.m_sendFailures.add();
+    } else {
+        m_metrics.m_packetsSent.add();
+        m_metrics.m_bytesSent.add(sent);
+    }
+    return sent;
+}
+
+void SharedMemoryTransceiver::onStart() {
+    if(m_state != Idle)
+        return;
+    if(m_pollFileDescriptor < 0) {
+        m_pollFileDescriptor = epoll_create1(EPOLL_CLOEXEC);
+        if(m_pollFileDescriptor < 0) {
+            error(std::string("Error creating epoll: ") + strerror(errno));
+            return;
+        }
+    }
+    const bool started = m_mode == Slave ? startListening() : startConnecting();
+    // Nothing for the host loop to poll until a later onStart succeeds
+    if(!started) {
+        close(m_pollFileDescriptor);
+        m_pollFileDescriptor = -1;
+    }
+}
+
+void SharedMemoryTransceiver::onStop() {
+    // A slave drops back to Listen, the socket goes too so a stop always ends in Idle
+    if(m_state == Connected || m_state == Handshake)
+        dropConnection("");
+    if(m_state == Listen) {
+        close(m_listenFileDescriptor);
+        m_listenFileDescriptor = -1;
+        unlink(m_path.c_str());
+    }
+    if(m_state != Idle) {
+        m_state = Idle;
+        m_metrics.m_stateTransitions.add();
+    }
+    closeCalled();
+}
+
+int SharedMemoryTransceiver::fileDescriptor() const {
+    return m_pollFileDescriptor;
+}
+
+SharedMemoryTransceiver::State SharedMemoryTransceiver::state() const {
+    return m_state;
+}
+
+void SharedMemoryTransceiver::onReadable() {
+    struct epoll_event events[4];
+    const int count = epoll_wait(m_pollFileDescriptor, events, 4, 0);
+    for(int i = 0; i < count; ++i) {
+        const int fileDescriptor = events[i].data.fd;
+        if(fileDescriptor == m_listenFileDescriptor) {
+            onAccept();
+        } else if(fileDescriptor == m_connectionFileDescriptor) {
+            if(m_state == Handshake)
+                onHandshakeReadable();
+            else
+                onConnectionReadable();
+        } else if(m_ring.isAttached() && fileDescriptor == m_ring.eventFileDescriptor()) {
+            drainRing();
+        }
+    }
+}
+
+bool SharedMemoryTransceiver::startListening() {
+    struct sockaddr_un address;
+    if(!socketAddress(m_path, address)) {
+        error("Error, socket path too long: " + m_path);
+        return false;
+    }
+    m_listenFileDescriptor = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(m_listenFileDescriptor < 0) {
+        error(std::string("Error creating socket: ") + strerror(errno));
+        return false;
+    }
+    // A socket file left behind by a crashed driver would make bind fail forever
+    unlink(m_path.c_str());
+    if(bind(m_listenFileDescriptor, (const struct sockaddr*)&address, sizeof(address)) < 0 || listen(m_listenFileDescriptor, 1) < 0) {
+        error("Error listening on: " + m_path + ", " + strerror(errno));
+        close(m_listenFileDescriptor);
+        m_listenFileDescriptor = -1;
+        return false;
+    }
+    watch(m_listenFileDescriptor);
+    m_state = Listen;
+    m_metrics.m_stateTransitions.add();
+    return true;
+}
+
+bool SharedMemoryTransceiver::startConnecting() {
+    struct sockaddr_un address;
+    if(!socketAddress(m_path, address)) {
+        error("Error, socket path too long: " + m_path);
+        return false;
+    }
+    m_connectionFileDescriptor = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(m_connectionFileDescriptor < 0) {
+        error(std::string("Error creating socket: ") + strerror(errno));
+        return false;
+    }
+    if(connect(m_connectionFileDescriptor, (const struct sockaddr*)&address, sizeof(address)) < 0) {
+        error("Error connecting to driver at: " + m_path + ", " + strerror(errno));
+        close(m_connectionFileDescriptor);
+        m_connectionFileDescriptor = -1;
+        return false;
+    }
+    watch(m_connectionFileDescriptor);
+    m_state = Handshake;
+    m_metrics.m_stateTransitions.add();
+    return true;
+}
+
+void SharedMemoryTransceiver::onAccept() {
+    const int connection = accept4(m_listenFileDescriptor, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(connection < 0)
+        return;
+    // One producer per ring, a second one is turned away
+    if(m_state == Connected) {
+        close(connection);
+        return;
+    }
+    if(!m_ring.create()) {
+        error(std::string("Error creating shared memory: ") + strerror(errno));
+        close(connection);
+        return;
+    }
+    if(!sendDescriptors(connection, m_ring.memoryFileDescriptor(), m_ring.eventFileDescriptor())) {
+        m_ring.detach();
+        close(connection);
+        return;
+    }
+    m_connectionFileDescriptor = connection;
+    watch(m_connectionFileDescriptor);
+    watch(m_ring.eventFileDescriptor());
+    m_state = Connected;
+    m_metrics.m_stateTransitions.add();
+    m_handshake.await();
+    m_linkQuality.start();
+    connected();
+}
+
+void SharedMemoryTransceiver::onHandshakeReadable() {
+    int memoryFileDescriptor, eventFileDescriptor;
+    if(!receiveDescriptors(m_connectionFileDescriptor, memoryFileDescriptor, eventFileDescriptor)) {
+        dropConnection("Error, no shared memory from the driver at: " + m_path);
+        return;
+    }
+    if(!m_ring.attach(memoryFileDescriptor, eventFileDescriptor)) {
+        dropConnection("Error mapping shared memory from the driver");
+        return;
+    }
+    m_state = Connected;
+    m_metrics.m_stateTransitions.add();
+    connected();
+    m_handshake.offer();
+}
+
+void SharedMemoryTransceiver::onConnectionReadable() {
+    ssize_t size;
+    m_frame.resize(2048);
+    // Only control travels over the socket
+    while((size = recv(m_connectionFileDescriptor, m_frame.data(), m_frame.size(), MSG_DONTWAIT)) > 0) {
+        m_metrics.m_packetsReceived.add();
+        m_metrics.m_bytesReceived.add(size);
+        if(m_frame[0] & ControlMessage::ControlBit)
+            onControl(std::vector<uint8_t>(m_frame.begin(), m_frame.begin() + size));
+        else
+            m_metrics.m_packetsIgnored.add();
+    }
+    // Zero is the other end hanging up, the sequenced packet socket has no empty messages otherwise
+    if(size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        dropConnection("");
+}
+
+void SharedMemoryTransceiver::onControl(const std::vector<uint8_t> &data) {
+    if(data[0] == ControlMessage::Capabilities)
+        m_handshake.onCapabilities(data);
+    else if(data[0] == ControlMessage::Ping)
+        m_linkQuality.onPing(data);
+    else if(data[0] == ControlMessage::Pong)
+        m_linkQuality.onPong(data);
+    controlArrived(data);
+}
+
+void SharedMemoryTransceiver::drainRing() {
+    m_ring.clearWakeup();
+    do {
+        while(m_ring.pop(m_frame)) {
+            m_metrics.m_packetsReceived.add();
+            m_metrics.m_bytesReceived.add(m_frame.size());
+            if(ControlMessage::isControl(m_frame))
+                onControl(m_frame);
+            else
+                dataArrived(m_frame);
+        }
+    } while(!m_ring.arm());
+}
+
+void SharedMemoryTransceiver::watch(const int &fileDescriptor) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fileDescriptor;
+    epoll_ctl(m_pollFileDescriptor, EPOLL_CTL_ADD, fileDescriptor, &event);
+}
+
+void SharedMemoryTransceiver::unwatch(const int &fileDescriptor) {
+    epoll_ctl(m_pollFileDescriptor, EPOLL_CTL_DEL, fileDescriptor, nullptr);
+}
+
+void SharedMemoryTransceiver::dropConnection(const std::string &reason) {
+    const bool wasConnected = m_state == Connected;
+    // Frames the producer queued before hanging up still count
+    if(m_mode == Slave && wasConnected)
+        drainRing();
+    m_handshake.stop();
+    m_linkQuality.stop();
+    // The producer holds the same eventfd, closing ours alone would leave it in the epoll set
+    if(m_ring.isAttached())
+        unwatch(m_ring.eventFileDescriptor());
+    if(m_connectionFileDescriptor >= 0) {
+        unwatch(m_connectionFileDescriptor);
+        close(m_connectionFileDescriptor);
+    }
+    m_connectionFileDescriptor = -1;
+    m_ring.detach();
+    if(m_mode == Slave) {
+        m_state = Listen;
+        m_metrics.m_stateTransitions.add();
+    } else {
+        m_state = Idle;
+        m_metrics.m_stateTransitions.add();
+        if(!reason.empty())
+            error(reason);
+    }
+    if(wasConnected)
+        disconnected(reason);
+}
@@ -0,0 +1,57 @@
+#ifndef SHAREDMEMORYTRANSCEIVER_H
+#define SHAREDMEMORYTRANSCEIVER_H
+
+#include "transceiver/abstracttransceiver.h"
+#include "transceiver/sharedmemoryring.h"
+
+// Same-host transport for bots and remappers running next to the driver, no network stack involved.
+// The slave (driver) listens on a unix socket and hands each producer a ring and its eventfd over it,
+// input then goes through the ring and only rumble and hangups use the socket.
+// The host loop polls fileDescriptor() and calls onReadable()
+class SharedMemoryTransceiver : public AbstractTransceiver {
+public:
+    enum State {
+        Idle,
+        Listen,
+        Handshake,
+        Connected,
+    };
+
+    SharedMemoryTransceiver(const Mode &mode, const std::string &path = defaultPath());
+    ~SharedMemoryTransceiver();
+
+    // $XDG_RUNTIME_DIR/openrudder.sock, or a per user path in /tmp
+    static std::string defaultPath();
+
+    // Master writes input into the ring, slave sends feedback over the socket
+    int64_t sendData(const std::vector<uint8_t> &data, const bool &acknowledge = false) override;
+    // Slave: Idle -> Listen, master: Idle -> Handshake. onStop tears down to Idle from any state and emits closeCalled
+    void onStart() override;
+    void onStop() override;
+
+    int fileDescriptor() const override;
+    void onReadable() override;
+    State state() const;
+
+private:
+    bool startListening();
+    bool startConnecting();
+    void onAccept();
+    void onConnectionReadable();
+    void onHandshakeReadable();
+    void onControl(const std::vector<uint8_t> &data);
+    void drainRing();
+    void watch(const int &fileDescriptor);
+    void unwatch(const int &fileDescriptor);
+    void dropConnection(const std::string &reason);
+
+    int m_pollFileDescriptor;
+    int m_listenFileDescriptor;
+    int m_connectionFileDescriptor;
+    State m_state;
+    std::string m_path;
+    SharedMemoryRing m_ring;
+    std::vector<uint8_t> m_frame;
+};
+
+#endif // SHAREDMEMORYTRANSCEIVER_H
@@ -0,0 +1,33 @@
+#include "transportmetrics.h"
+
+TransportMetrics::TransportMetrics(): m_published(false) {
+}
+
+TransportMetrics::~TransportMetrics() {
+    if(!m_published)
+        return;
+    Metrics::Registry *registry = Metrics::Registry::instance();
+    registry->remove(&m_packetsReceived);
+    registry->remove(&m_bytesReceived);
+    registry->remove(&m_packetsIgnored);
+    registry->remove(&m_duplicatesDropped);
+    registry->remove(&m_packetsSent);
+    registry->remove(&m_bytesSent);
+    registry->remove(&m_sendFailures);
+    registry->remove(&m_stateTransitions);
+}
+
+void TransportMetrics::publish(const std::string &labels) {
+    if(m_published)
+        return;
+    m_published = true;
+    Metrics::Registry *registry = Metrics::Registry::instance();
+    registry->add("openrudder_transport_packets_received_total", "Datagrams or frames received", labels, &m_packetsReceived);
+    registry->add("openrudder_transport_bytes_received_total", "Bytes received", labels, &m_bytesReceived);
+    registry->add("openrudder_transport_packets_ignored_total", "Received packets dropped unprocessed", labels, &m_packetsIgnored);
+    registry->add("openrudder_transport_duplicates_dropped_total", "Redundant input copies already passed on", labels, &m_duplicatesDropped);
+    registry->add("openrudder_transport_packets_sent_total", "Datagrams or frames sent", labels, &m_packetsSent);
+    registry->add("openrudder_transport_bytes_sent_total", "Bytes sent", labels, &m_bytesSent);
+    registry->add("openrudder_transport_send_failures_total", "Sends refused by the socket or ring", labels, &m_sendFailures);
+    registry->add("openrudder_transport_state_transitions_total", "Transceiver state changes", labels, &m_stateTransitions);
+}
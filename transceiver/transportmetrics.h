@@ -0,0 +1,33 @@
+#ifndef TRANSPORTMETRICS_H
+#define TRANSPORTMETRICS_H
+
+#include "common/metrics.h"
+
+// Counters every transceiver keeps. Receive side counters are written by the thread reading the socket,
+// send side ones by the thread calling sendData, each by one thread only
+struct TransportMetrics {
+    TransportMetrics();
+    ~TransportMetrics();
+    TransportMetrics(const TransportMetrics &) = delete;
+    TransportMetrics &operator=(const TransportMetrics &) = delete;
+
+    // Makes the counters visible to the metrics server, once the owner knows its labels
+    void publish(const std::string &labels);
+
+    Metrics::Counter m_packetsReceived;
+    Metrics::Counter m_bytesReceived;
+    // Received but ignored, from an unknown host or in a state that takes nothing
+    Metrics::Counter m_packetsIgnored;
+    // Redundant copies of input already passed on
+    Metrics::Counter m_duplicatesDropped;
+    Metrics::Counter m_packetsSent;
+    Metrics::Counter m_bytesSent;
+    // Sends the socket or ring refused
+    Metrics::Counter m_sendFailures;
+    Metrics::Counter m_stateTransitions;
+
+private:
+    bool m_published;
+};
+
+#endif // TRANSPORTMETRICS_H
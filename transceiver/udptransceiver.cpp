@@ -0,0 +1,207 @@
+#include "udptransceiver.h"
+#include "common/trace.h"
+#include "event/controlmessage.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+UdpTransceiver::UdpTransceiver(const std::string &interfaceAddress, const uint16_t &port):
+    AbstractTransceiver(Mode::Slave),
+    m_fileDescriptor(-1),
+    m_state(Idle),
+    m_interfaceAddress(interfaceAddress),
+    m_port(port),
+    m_broadcastPeriodms(200),
+    m_timeoutms(1000),
+    m_buffer(2048)
+{
+    memset(&m_masterHost, 0, sizeof(m_masterHost));
+    m_broadcastTimer.setCallback([this] () {
+        struct sockaddr_in destination;
+        memset(&destination, 0, sizeof(destination));
+        destination.sin_family = AF_INET;
+        destination.sin_port = htons(m_port);
+        destination.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+        sendto(m_fileDescriptor, nullptr, 0, 0, (const struct sockaddr*)&destination, sizeof(destination));
+    });
+    // Master went quiet, same as the slave pressing stop
+    m_keepaliveTimer.setCallback([this] () {
+        onStop();
+    });
+    const auto send = [this] (const std::vector<uint8_t> &data) {
+        sendData(data);
+    };
+    m_handshake.setSend(send);
+    m_linkQuality.setSend(send);
+    m_metrics.publish("transport=\"udp\",role=\"slave\"");
+}
+
+UdpTransceiver::~UdpTransceiver() {
+    if(m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+}
+
+int64_t UdpTransceiver::sendData(const std::vector<uint8_t> &data, const bool &/*acknowledge*/) {
+    TRACE_SCOPE("send");
+    if(m_state != ReceiveInput)
+        return -1;
+    // Redundancy is for master input, feedback goes out once
+    const ssize_t sent = sendto(m_fileDescriptor, data.data(), data.size(), 0, (const struct sockaddr*)&m_masterHost, sizeof(m_masterHost));
+    if(sent < 0) {
+        m_metrics.m_sendFailures.add();
+    } else {
+        m_metrics.m_packetsSent.add();
+        m_metrics.m_bytesSent.add(sent);
+    }
+    return sent;
+}
+
+void UdpTransceiver::onStart() {
+    if(m_state != Idle)
+        return;
+    if(!bindSocket())
+        return;
+    enterBroadcast();
+}
+
+void UdpTransceiver::onStop() {
+    if(m_state == ReceiveInput) {
+        const uint8_t quit = ControlMessage::Quit;
+        sendto(m_fileDescriptor, &quit, sizeof(quit), 0, (const struct sockaddr*)&m_masterHost, sizeof(m_masterHost));
+        m_keepaliveTimer.stop();
+        m_handshake.stop();
+        m_linkQuality.stop();
+        disconnected("");
+        enterBroadcast();
+    } else if(m_state == Broadcast) {
+        m_broadcastTimer.stop();
+        m_state = Idle;
+        m_metrics.m_stateTransitions.add();
+        TRACE_INSTANT("state transition");
+        closeCalled();
+    }
+}
+
+int UdpTransceiver::fileDescriptor() const {
+    return m_fileDescriptor;
+}
+
+UdpTransceiver::State UdpTransceiver::state() const {
+    return m_state;
+}
+
+void UdpTransceiver::setBroadcastPeriod(const uint32_t &ms) {
+    m_broadcastPeriodms = ms;
+}
+
+void UdpTransceiver::setTimeout(const uint32_t &ms) {
+    m_timeoutms = ms;
+}
+
+void UdpTransceiver::onReadable() {
+    TRACE_SCOPE("receive");
+    struct sockaddr_in sender;
+    socklen_t senderSize = sizeof(sender);
+    ssize_t size;
+    // Drain the socket, the loop only tells us once
+    while((size = recvfrom(m_fileDescriptor, m_buffer.data(), m_buffer.size(), MSG_DONTWAIT, (struct sockaddr*)&sender, &senderSize)) >= 0) {
+        senderSize = sizeof(sender);
+        m_metrics.m_packetsReceived.add();
+        m_metrics.m_bytesReceived.add(size);
+        if(m_state == Broadcast) {
+            // Bound to any address we hear our own empty broadcasts, whatever the master sends isn't empty
+            if(size == 0) {
+                m_metrics.m_packetsIgnored.add();
+                continue;
+            }
+            enterReceiveInput(sender);
+        } else if(m_state != ReceiveInput || sender.sin_addr.s_addr != m_masterHost.sin_addr.s_addr) {
+            m_metrics.m_packetsIgnored.add();
+            continue;
+        }
+        m_keepaliveTimer.start(m_timeoutms);
+        if(size > 0 && m_buffer[0] & ControlMessage::ControlBit) {
+            onControl(std::vector<uint8_t>(m_buffer.begin(), m_buffer.begin() + size));
+            continue;
+        }
+        std::vector<uint8_t> data(m_buffer.begin(), m_buffer.begin() + size);
+        if(acceptInput(data))
+            dataArrived(data);
+    }
+    if(errno != EAGAIN && errno != EWOULDBLOCK) {
+        error(std::string("Error receiving: ") + strerror(errno));
+    }
+}
+
+void UdpTransceiver::onControl(const std::vector<uint8_t> &data) {
+    // The master hung up, no need to wait for the keepalive
+    if(data[0] == ControlMessage::Quit) {
+        m_keepaliveTimer.stop();
+        m_handshake.stop();
+        m_linkQuality.stop();
+        disconnected("");
+        enterBroadcast();
+        return;
+    }
+    if(data[0] == ControlMessage::Capabilities)
+        m_handshake.onCapabilities(data);
+    else if(data[0] == ControlMessage::Pong)
+        m_linkQuality.onPong(data);
+    controlArrived(data);
+}
+
+bool UdpTransceiver::bindSocket() {
+    if(m_fileDescriptor >= 0)
+        return true;
+    m_fileDescriptor = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(m_fileDescriptor < 0) {
+        error(std::string("Error creating socket: ") + strerror(errno));
+        return false;
+    }
+    const int enable = 1;
+    setsockopt(m_fileDescriptor, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+    setsockopt(m_fileDescriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(m_port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(!m_interfaceAddress.empty() && inet_pton(AF_INET, m_interfaceAddress.c_str(), &address.sin_addr) != 1) {
+        error("Error, bad interface address: " + m_interfaceAddress);
+        close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+        return false;
+    }
+    if(bind(m_fileDescriptor, (const struct sockaddr*)&address, sizeof(address)) < 0) {
+        error("Error binding socket to host: " + (m_interfaceAddress.empty() ? std::string("any") : m_interfaceAddress) + ", port: " + std::to_string(m_port));
+        close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+        return false;
+    }
+    return true;
+}
+
+void UdpTransceiver::enterBroadcast() {
+    m_state = Broadcast;
+    m_metrics.m_stateTransitions.add();
+    TRACE_INSTANT("state transition");
+    m_broadcastTimer.start(m_broadcastPeriodms);
+}
+
+void UdpTransceiver::enterReceiveInput(const struct sockaddr_in &master) {
+    m_broadcastTimer.stop();
+    m_masterHost = master;
+    m_masterHost.sin_port = htons(m_port);
+    m_state = ReceiveInput;
+    m_metrics.m_stateTransitions.add();
+    TRACE_INSTANT("state transition");
+    m_keepaliveTimer.start(m_timeoutms);
+    m_handshake.await();
+    m_linkQuality.start();
+    connected();
+}
@@ -0,0 +1,53 @@
+#ifndef UDPTRANSCEIVER_H
+#define UDPTRANSCEIVER_H
+
+#include "transceiver/abstracttransceiver.h"
+#include "common/timerwheel.h"
+#include <netinet/in.h>
+
+// Slave side of NetworkTransceiver's protocol on plain POSIX sockets, for the headless daemon.
+// Broadcasts until a master answers, then receives input until the keepalive times out.
+// The host loop polls fileDescriptor() and calls onReadable()
+class UdpTransceiver : public AbstractTransceiver {
+public:
+    enum State {
+        Idle,
+        Broadcast,
+        ReceiveInput,
+    };
+
+    // Empty interface address binds to all interfaces
+    UdpTransceiver(const std::string &interfaceAddress = std::string(), const uint16_t &port = 45800);
+    ~UdpTransceiver();
+
+    int64_t sendData(const std::vector<uint8_t> &data, const bool &acknowledge = false) override;
+    // Idle -> Broadcast, and the reverse transitions for onStop like NetworkTransceiver
+    void onStart() override;
+    void onStop() override;
+
+    int fileDescriptor() const override;
+    void onReadable() override;
+    State state() const;
+
+    void setBroadcastPeriod(const uint32_t &ms);
+    void setTimeout(const uint32_t &ms);
+
+private:
+    bool bindSocket();
+    void onControl(const std::vector<uint8_t> &data);
+    void enterBroadcast();
+    void enterReceiveInput(const struct sockaddr_in &master);
+
+    int m_fileDescriptor;
+    State m_state;
+    std::string m_interfaceAddress;
+    uint16_t m_port;
+    struct sockaddr_in m_masterHost;
+    uint32_t m_broadcastPeriodms;
+    uint32_t m_timeoutms;
+    TimerWheel::Timer m_broadcastTimer;
+    TimerWheel::Timer m_keepaliveTimer;
+    std::vector<uint8_t> m_buffer;
+};
+
+#endif // UDPTRANSCEIVER_H
@@ -0,0 +1,24 @@
+#ifndef ABSTRACTTOUCHCONTROL_H
+#define ABSTRACTTOUCHCONTROL_H
+
+#include <QPointF>
+
+// Controls receive their touch points from TouchDispatcher instead of handling QTouchEvent.
+// A pointer stays with the control it landed on until it lifts, positions are control local
+class AbstractTouchControl {
+public:
+    struct TouchPointer {
+        int id;
+        QPointF pos;
+        qreal pressure; // Negative when the touch device doesn't report pressure
+    };
+
+    virtual ~AbstractTouchControl() {}
+
+    virtual void touchBegin(const TouchPointer &pointer) = 0;
+    virtual void touchUpdate(const TouchPointer &pointer) = 0;
+    virtual void touchEnd(const TouchPointer &pointer) = 0;
+    virtual void touchCancel(const int &id) = 0;
+};
+
+#endif // ABSTRACTTOUCHCONTROL_H
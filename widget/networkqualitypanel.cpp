@@ -0,0 +1,107 @@
+#include "networkqualitypanel.h"
+#include <QFormLayout>
+#include <climits>
+
+static const int RefreshPeriodms = 500;
+// Five seconds of refreshes, enough pings for the loss to mean something
+static const int HistorySize = 11;
+// Beyond these the link rather than the game is the likely cause, Wi-Fi shows up as jitter and loss long before the round trip grows
+static const double LossThreshold = 0.02;
+static const uint32_t JitterThresholdus = 4000;
+
+NetworkQualityPanel::NetworkQualityPanel(const AbstractTransceiver *transceiver, QWidget *parent):
+    QWidget(parent),
+    m_transceiver(transceiver),
+    m_rateLabel(new QLabel(this)),
+    m_rttLabel(new QLabel(this)),
+    m_jitterLabel(new QLabel(this)),
+    m_lossLabel(new QLabel(this)),
+    m_latencyLabel(new QLabel(this)),
+    m_verdictLabel(new QLabel(this))
+{
+    QFormLayout *layout = new QFormLayout(this);
+    layout->addRow(tr("Packets"), m_rateLabel);
+    layout->addRow(tr("Round trip"), m_rttLabel);
+    layout->addRow(tr("Jitter"), m_jitterLabel);
+    layout->addRow(tr("Loss"), m_lossLabel);
+    layout->addRow(tr("Input latency"), m_latencyLabel);
+    layout->addRow(m_verdictLabel);
+
+    m_timer.setInterval(RefreshPeriodms);
+    connect(&m_timer, &QTimer::timeout, this, &NetworkQualityPanel::refresh);
+    m_clock.start();
+}
+
+void NetworkQualityPanel::showEvent(QShowEvent *event) {
+    // A new history each time, the numbers of a previous session would only skew it
+    m_history.clear();
+    m_history.push_back(sample());
+    refresh();
+    m_timer.start();
+    QWidget::showEvent(event);
+}
+
+void NetworkQualityPanel::hideEvent(QHideEvent *event) {
+    m_timer.stop();
+    QWidget::hideEvent(event);
+}
+
+void NetworkQualityPanel::refresh() {
+    const Sample latest = sample();
+    const Sample &previous = m_history.last();
+    const Sample &oldest = m_history.first();
+
+    const qint64 elapsedms = latest.elapsedms - previous.elapsedms;
+    const double rate = elapsedms > 0 ? (latest.packets - previous.packets) * 1000.0 / elapsedms : 0;
+    m_rateLabel->setText(tr("%1/s").arg(qRound(rate)));
+
+    const LinkQuality::Snapshot &quality = latest.quality;
+    if(!quality.rttus) {
+        m_rttLabel->setText(tr("n/a"));
+        m_jitterLabel->setText(tr("n/a"));
+    } else {
+        m_rttLabel->setText(formatLatency(quality.rttus));
+        m_jitterLabel->setText(formatLatency(quality.jitterus));
+    }
+
+    const uint64_t pings = quality.pingsSent - oldest.quality.pingsSent;
+    const double loss = pings ? double(quality.pingsLost - oldest.quality.pingsLost) / pings : 0;
+    m_lossLabel->setText(pings ? tr("%1%").arg(loss * 100, 0, 'f', 1) : tr("n/a"));
+
+    const uint32_t p50 = LinkQuality::percentile(quality, oldest.quality, 0.50);
+    if(!p50) {
+        m_latencyLabel->setText(tr("n/a"));
+    } else {
+        m_latencyLabel->setText(tr("p50 %1, p95 %2, p99 %3").arg(formatLatency(p50),
+                                formatLatency(LinkQuality::percentile(quality, oldest.quality, 0.95)),
+                                formatLatency(LinkQuality::percentile(quality, oldest.quality, 0.99))));
+    }
+
+    if(!pings || !quality.rttus)
+        m_verdictLabel->setText(tr("Measuring..."));
+    else if(loss > LossThreshold)
+        m_verdictLabel->setText(tr("Packets are being lost, check the Wi-Fi signal"));
+    else if(quality.jitterus > JitterThresholdus)
+        m_verdictLabel->setText(tr("Delay is unstable, the network is likely congested or on weak Wi-Fi"));
+    else
+        m_verdictLabel->setText(tr("Network looks fine"));
+
+    m_history.push_back(latest);
+    if(m_history.size() > HistorySize)
+        m_history.removeFirst();
+}
+
+QString NetworkQualityPanel::formatLatency(const uint32_t &us) {
+    // The last latency bucket has no upper bound
+    if(us == UINT32_MAX)
+        return tr("> %1 ms").arg(LinkQuality::LatencyBoundsus[LinkQuality::LatencyBuckets - 2] / 1000);
+    return tr("%1 ms").arg(us / 1000.0, 0, 'f', 1);
+}
+
+NetworkQualityPanel::Sample NetworkQualityPanel::sample() const {
+    Sample sample;
+    sample.elapsedms = m_clock.elapsed();
+    sample.packets = m_transceiver->metrics().m_packetsReceived.value();
+    sample.quality = m_transceiver->linkQuality().snapshot();
+    return sample;
+}
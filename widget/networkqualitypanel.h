@@ -0,0 +1,49 @@
+#ifndef NETWORKQUALITYPANEL_H
+#define NETWORKQUALITYPANEL_H
+
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+#include "transceiver/abstracttransceiver.h"
+
+// Packet rate, round trip, jitter, loss and input latency percentiles of the session being received.
+// Samples the transceiver's counters twice a second while visible, reading only relaxed atomics,
+// so the input thread never waits on it
+class NetworkQualityPanel : public QWidget {
+    Q_OBJECT
+public:
+    explicit NetworkQualityPanel(const AbstractTransceiver *transceiver, QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+
+private:
+    struct Sample {
+        qint64 elapsedms;
+        uint64_t packets;
+        LinkQuality::Snapshot quality;
+    };
+
+    static QString formatLatency(const uint32_t &us);
+    Sample sample() const;
+
+    const AbstractTransceiver *m_transceiver;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    // Loss and percentiles are taken over the whole history, the rate over the last refresh only
+    QVector <Sample> m_history;
+    QLabel *m_rateLabel;
+    QLabel *m_rttLabel;
+    QLabel *m_jitterLabel;
+    QLabel *m_lossLabel;
+    QLabel *m_latencyLabel;
+    QLabel *m_verdictLabel;
+};
+
+#endif // NETWORKQUALITYPANEL_H
@@ -1,8 +1,11 @@
 #include <QNetworkInterface>
+#include "common/trace.h"
 #include <QMessageBox>
 #include <QPainter>
 #include "common/common.h"
+#include "common/svgrasterizer.h"
 #include "networktransceiverwidget.h"
+#include "networkqualitypanel.h"
 #include "ui_networktransceivermaster.h"
 #include "ui_networktransceiverslave.h"
 
@@ -29,13 +32,13 @@ NetworkTransceiverWidget::NetworkTransceiverWidget(NetworkTransceiver *transceiv
 void NetworkTransceiverWidget::loadMasterUI() {
     masterUi = new Ui::NetworkTransceiverMaster();
     masterUi->setupUi(this);
-    int logoSize = width() < height() ? width() * 0.5 : height() * 0.5;
-    m_logoPixmap = Common::renderSvg(":/emulator-logo.svg", QSize(logoSize, logoSize));
-    masterUi->logoLabel->setPixmap(*m_logoPixmap);
+    loadLogo(masterUi->logoLabel, 0.5);
 
     // INIT
     connect(masterUi->startPushButton, &QPushButton::clicked, m_transceiver, &NetworkTransceiver::onStart);
-    connect(masterUi->backPushButton, &QPushButton::clicked, m_transceiver, &NetworkTransceiver::closeCalled);
+    connect(masterUi->backPushButton, &QPushButton::clicked, [this] () {
+        m_transceiver->closeCalled();
+    });
     masterUi->networkInterfaceComboBox->addItem("", QVariant::fromValue <QHostAddress> (QHostAddress::Null));
     for(const QHostAddress &address: m_interfaces) {
         masterUi->networkInterfaceComboBox->addItem(address.toString(), QVariant::fromValue <QHostAddress> (address));
@@ -68,18 +71,21 @@ void NetworkTransceiverWidget::loadMasterUI() {
 void NetworkTransceiverWidget::loadSlaveUI() {
     slaveUi = new Ui::NetworkTransceiverSlave();
     slaveUi->setupUi(this);
-    int logoSize = width() < height() ? width() * 0.75 : height() * 0.75;
-    m_logoPixmap = Common::renderSvg(":/emulator-logo.svg", QSize(logoSize, logoSize));
-    slaveUi->logoLabel->setPixmap(*m_logoPixmap);
+    loadLogo(slaveUi->logoLabel, 0.75);
 
     m_broadcastAnimation = new StatusAnimation(StatusAnimation::Broadcast, this);
     m_receiveAnimation = new StatusAnimation(StatusAnimation::ReceiveInput, this);
     slaveUi->broadcastAnimationLayout->addWidget(m_broadcastAnimation);
     slaveUi->receiveInputAnimationLayout->addWidget(m_receiveAnimation);
+    // Only polls while the receive page is up
+    m_qualityPanel = new NetworkQualityPanel(m_transceiver, this);
+    slaveUi->receiveInputAnimationLayout->addWidget(m_qualityPanel);
 
     // INIT
     connect(slaveUi->startPushButton, &QPushButton::clicked, m_transceiver, &NetworkTransceiver::onStart);
-    connect(slaveUi->quitPushButton, &QPushButton::clicked, m_transceiver, &NetworkTransceiver::closeCalled);
+    connect(slaveUi->quitPushButton, &QPushButton::clicked, [this] () {
+        m_transceiver->closeCalled();
+    });
     slaveUi->networkInterfaceComboBox->clear();
     slaveUi->networkInterfaceComboBox->addItem("", QVariant::fromValue <QHostAddress> (QHostAddress::Null));
     for(const QHostAddress &address: m_interfaces) {
@@ -97,6 +103,15 @@ void NetworkTransceiverWidget::loadSlaveUI() {
     connect(slaveUi->stopReceivingPushButton, &QPushButton::clicked, m_transceiver, &NetworkTransceiver::onStop);
 }
 
+void NetworkTransceiverWidget::loadLogo(QLabel *label, const qreal &scale) {
+    // Label stays empty until the worker delivers the raster
+    const int logoSize = width() < height() ? width() * scale : height() * scale;
+    SvgRasterizer::instance()->rasterize(QStringList(":/emulator-logo.svg"), QSize(logoSize, logoSize), label, [label] (const QVector<QImage> &images) {
+        if(!images.first().isNull())
+            label->setPixmap(QPixmap::fromImage(images.first()));
+    });
+}
+
 void NetworkTransceiverWidget::onStateChanged(NetworkTransceiver::State state) {
     // Clear host list on every state change
     if(m_transceiver->mode() == NetworkTransceiver::Master)
@@ -146,27 +161,34 @@ void NetworkTransceiverWidget::onHostFound(QString address) {
 }
 
 NetworkTransceiverWidget::StatusAnimation::StatusAnimation(const Status status, NetworkTransceiverWidget *transWidget):
-QWidget(transWidget), m_status(status), m_transWidget(transWidget), m_currentPixmapIndex(0) {
+QWidget(transWidget), m_loadGeneration(0), m_status(status), m_transWidget(transWidget), m_currentPixmapIndex(0) {
     connect(&m_timer, &QTimer::timeout, this, &StatusAnimation::onTimeOut);
     if(status == Status::Broadcast)
         m_periodms = 100;
     else if (status == Status::ReceiveInput)
         m_periodms = 750;
-    m_pixmapLoadTimer.setInterval(1000);
+    m_pixmapLoadTimer.setInterval(100);
     m_pixmapLoadTimer.setSingleShot(true);
     connect(&m_pixmapLoadTimer, &QTimer::timeout, this, &StatusAnimation::loadPixmaps);
 }
 
 void NetworkTransceiverWidget::StatusAnimation::onTimeOut() {
+    if(m_pixmap.empty())
+        return;
     ++m_currentPixmapIndex;
     m_currentPixmapIndex %= m_pixmap.size();
-    repaint();
+    update();
 }
 
 void NetworkTransceiverWidget::StatusAnimation::paintEvent(QPaintEvent *event) {
-    if(m_pixmap.empty())
-        loadPixmaps();
-    QPixmap *pixmap = m_pixmap[m_currentPixmapIndex].data();
+    TRACE_SCOPE("paint status");
+    // Nothing to show until the first frame set arrives, after a resize the old set stays up meanwhile
+    if(m_pixmap.empty()) {
+        if(m_loadingSize.isEmpty())
+            loadPixmaps();
+        return;
+    }
+    const QPixmap *pixmap = &m_pixmap[m_currentPixmapIndex];
     const int sX = rect().x() + (rect().width() - pixmap->width())/2;
     const int sY = rect().y() + (rect().height() - pixmap->height())/2;
     const int sW = pixmap->width();
@@ -185,15 +207,32 @@ void NetworkTransceiverWidget::StatusAnimation::start() {
 
 void NetworkTransceiverWidget::StatusAnimation::loadPixmaps() {
     const QSize imageSize = this->size() * 0.5;
-    m_pixmap.clear();
+    if(imageSize.isEmpty())
+        return;
+    QStringList filenames;
     if(m_status == Status::Broadcast) {
         for(int i = 1; i <= 11; ++i)
-            m_pixmap.push_back(Common::renderSvg(":/nm-stage01-connecting" + QString::number(i).rightJustified(2, '0') +  ".svg", imageSize));
+            filenames.push_back(":/nm-stage01-connecting" + QString::number(i).rightJustified(2, '0') +  ".svg");
     } else if(m_status == Status::ReceiveInput) {
-        m_pixmap.push_back(Common::renderSvg(":/network-receive.svg", imageSize));
-        m_pixmap.push_back(Common::renderSvg(":/network-transmit-receive.svg", imageSize));
-        m_pixmap.push_back(Common::renderSvg(":/network-transmit.svg", imageSize));
+        filenames.push_back(":/network-receive.svg");
+        filenames.push_back(":/network-transmit-receive.svg");
+        filenames.push_back(":/network-transmit.svg");
     }
+
+    const int generation = ++m_loadGeneration;
+    m_loadingSize = imageSize;
+    SvgRasterizer::instance()->rasterize(filenames, imageSize, this, [this, generation] (const QVector<QImage> &images) {
+        if(generation != m_loadGeneration)
+            return;
+        // Swap the whole set at once
+        std::vector <QPixmap> pixmaps;
+        for(const QImage &image: images)
+            pixmaps.push_back(QPixmap::fromImage(image));
+        m_pixmap.swap(pixmaps);
+        m_currentPixmapIndex %= m_pixmap.size();
+        m_loadingSize = QSize();
+        update();
+    });
 }
 
 void NetworkTransceiverWidget::StatusAnimation::resizeEvent(QResizeEvent *event) {
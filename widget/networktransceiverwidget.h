@@ -11,6 +11,8 @@ class NetworkTransceiverMaster;
 class NetworkTransceiverSlave;
 }
 
+class NetworkQualityPanel;
+
 class NetworkTransceiverWidget : public QWidget {
     Q_OBJECT
 public:
@@ -25,16 +27,17 @@ public slots:
 private:
     void loadMasterUI();
     void loadSlaveUI();
+    void loadLogo(QLabel *label, const qreal &scale);
 
     NetworkTransceiver *m_transceiver;
     QList <QHostAddress> m_interfaces;
     // Different ui's loaded for each mode
     Ui::NetworkTransceiverMaster *masterUi;
     Ui::NetworkTransceiverSlave *slaveUi;
-    QSharedPointer<QPixmap> m_logoPixmap;
     class StatusAnimation;
     StatusAnimation *m_broadcastAnimation;
     StatusAnimation *m_receiveAnimation;
+    NetworkQualityPanel *m_qualityPanel;
 };
 
 class NetworkTransceiverWidget::StatusAnimation: public QWidget {
@@ -61,11 +64,14 @@ private slots:
 private:
     void loadPixmaps();
     QTimer m_pixmapLoadTimer;
+    // Bumped per request so a late raster of an outdated size is discarded
+    int m_loadGeneration;
+    QSize m_loadingSize;
     Status m_status;
     NetworkTransceiverWidget *m_transWidget;
     // Animation data
     int m_currentPixmapIndex;
-    std::vector <QSharedPointer<QPixmap>> m_pixmap;
+    std::vector <QPixmap> m_pixmap;
     QTimer m_timer;
     int m_periodms;
 };
@@ -0,0 +1,36 @@
+#include "repaintscheduler.h"
+#include "common/trace.h"
+#include <QGuiApplication>
+#include <QScreen>
+
+RepaintScheduler::RepaintScheduler() {
+    qreal refreshRate = 60;
+    if(QGuiApplication::primaryScreen() && QGuiApplication::primaryScreen()->refreshRate() > 0)
+        refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+    m_timer.setInterval(qMax(1, qRound(1000 / refreshRate)));
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &RepaintScheduler::onFrame);
+}
+
+RepaintScheduler *RepaintScheduler::instance() {
+    static RepaintScheduler scheduler;
+    return &scheduler;
+}
+
+void RepaintScheduler::schedule(QWidget *widget) {
+    RepaintScheduler *scheduler = instance();
+    if(!scheduler->m_dirty.contains(widget))
+        scheduler->m_dirty.push_back(widget);
+    if(!scheduler->m_timer.isActive())
+        scheduler->m_timer.start();
+}
+
+void RepaintScheduler::onFrame() {
+    TRACE_SCOPE("schedule repaint");
+    for(const QPointer<QWidget> &widget: m_dirty) {
+        if(widget)
+            widget->update();
+    }
+    m_dirty.clear();
+}
@@ -0,0 +1,28 @@
+#ifndef REPAINTSCHEDULER_H
+#define REPAINTSCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+// Collects dirty widgets and updates them together once per display refresh, so touch
+// handlers only mark a widget dirty and never wait on painting before they emit
+class RepaintScheduler : public QObject {
+    Q_OBJECT
+public:
+    static void schedule(QWidget *widget);
+
+private slots:
+    void onFrame();
+
+private:
+    RepaintScheduler();
+    static RepaintScheduler *instance();
+
+    QTimer m_timer;
+    QVector <QPointer<QWidget>> m_dirty;
+};
+
+#endif // REPAINTSCHEDULER_H
@@ -0,0 +1,116 @@
+#include "sticksendpolicy.h"
+#include <QtMath>
+
+namespace {
+qreal smoothingFactor(const qreal &cutoffHz, const qreal &dt) {
+    const qreal tau = 1.0 / (2 * M_PI * cutoffHz);
+    return 1.0 / (1.0 + tau / dt);
+}
+}
+
+StickSendPolicy::StickSendPolicy(QObject *parent) : QObject(parent),
+    m_epsilon(0.01), m_maxRateHz(120), m_sessionRateHz(0), m_minIntervalns(1000000000 / 120), m_restDelayns(50000000),
+    m_minCutoff(3.0), m_beta(5.0), m_derivativeCutoff(1.0), m_hasSample(false),
+    m_pending(false), m_lastUpdate(0), m_lastSendTime(0) {
+    m_clock.start();
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_flushTimer, &QTimer::timeout, this, &StickSendPolicy::onFlushTimeout);
+}
+
+void StickSendPolicy::setEpsilon(const qreal &epsilon) {
+    m_epsilon = epsilon;
+}
+
+void StickSendPolicy::setMaxRate(const int &hz) {
+    m_maxRateHz = qMax(0, hz);
+    updateInterval();
+}
+
+int StickSendPolicy::maxRate() const {
+    return m_maxRateHz;
+}
+
+void StickSendPolicy::setSessionRate(const int &hz) {
+    m_sessionRateHz = qMax(0, hz);
+    updateInterval();
+}
+
+void StickSendPolicy::updateInterval() {
+    int hz = m_maxRateHz;
+    if(m_sessionRateHz > 0 && (hz == 0 || m_sessionRateHz < hz))
+        hz = m_sessionRateHz;
+    m_minIntervalns = hz > 0 ? 1000000000 / hz : 0;
+}
+
+void StickSendPolicy::setFilter(const qreal &minCutoffHz, const qreal &beta) {
+    m_minCutoff = minCutoffHz;
+    m_beta = beta;
+}
+
+void StickSendPolicy::reset(const QPointF &point) {
+    m_flushTimer.stop();
+    m_hasSample = false;
+    m_derivative = QPointF();
+    m_filtered = m_raw = m_lastSent = point;
+    m_pending = false;
+    m_lastUpdate = m_lastSendTime = m_clock.nsecsElapsed();
+}
+
+void StickSendPolicy::update(const QPointF &point) {
+    const qint64 now = m_clock.nsecsElapsed();
+    const qreal dt = (now - m_lastUpdate) / 1e9;
+    m_lastUpdate = now;
+    m_raw = point;
+    m_filtered = filter(point, dt);
+
+    const QPointF change = m_filtered - m_lastSent;
+    m_pending = qSqrt(QPointF::dotProduct(change, change)) >= m_epsilon;
+    if(m_pending && now - m_lastSendTime >= m_minIntervalns)
+        sendNow(m_filtered, now);
+    scheduleFlush(now);
+}
+
+void StickSendPolicy::onFlushTimeout() {
+    const qint64 now = m_clock.nsecsElapsed();
+    if(m_pending) {
+        sendNow(m_filtered, now);
+    } else if(m_lastSent != m_raw && now - m_lastUpdate >= m_restDelayns) {
+        // Stick is resting, send the unfiltered position so the filter lag doesn't stick around
+        m_filtered = m_raw;
+        sendNow(m_raw, now);
+    }
+    scheduleFlush(now);
+}
+
+QPointF StickSendPolicy::filter(const QPointF &point, const qreal &dt) {
+    if(!m_hasSample || dt <= 0) {
+        m_hasSample = true;
+        return point;
+    }
+    const qreal derivativeAlpha = smoothingFactor(m_derivativeCutoff, dt);
+    m_derivative += ((point - m_filtered) / dt - m_derivative) * derivativeAlpha;
+    const qreal speed = qSqrt(QPointF::dotProduct(m_derivative, m_derivative));
+    const qreal alpha = smoothingFactor(m_minCutoff + m_beta * speed, dt);
+    return m_filtered + (point - m_filtered) * alpha;
+}
+
+void StickSendPolicy::sendNow(const QPointF &point, const qint64 &now) {
+    m_lastSent = point;
+    m_lastSendTime = now;
+    m_pending = false;
+    emit send(point);
+}
+
+void StickSendPolicy::scheduleFlush(const qint64 &now) {
+    qint64 deadline;
+    if(m_pending)
+        deadline = m_lastSendTime + m_minIntervalns;
+    else if(m_lastSent != m_raw)
+        deadline = qMax(m_lastSendTime + m_minIntervalns, m_lastUpdate + m_restDelayns);
+    else {
+        m_flushTimer.stop();
+        return;
+    }
+    m_flushTimer.start(int(qMax <qint64> (0, (deadline - now + 999999) / 1000000)));
+}
@@ -0,0 +1,63 @@
+#ifndef STICKSENDPOLICY_H
+#define STICKSENDPOLICY_H
+
+#include <QObject>
+#include <QPointF>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// Decides which stick positions are worth a datagram. Positions go through a One Euro filter,
+// changes smaller than epsilon are dropped and sends are capped at the configured rate.
+// Once the stick comes to rest the exact final position is always sent
+class StickSendPolicy : public QObject {
+    Q_OBJECT
+public:
+    explicit StickSendPolicy(QObject *parent = nullptr);
+
+    void setEpsilon(const qreal &epsilon);
+    void setMaxRate(const int &hz);
+    int maxRate() const;
+    // The session's tick rate, only ever lowers the configured cap. 0 lifts it
+    void setSessionRate(const int &hz);
+    void setFilter(const qreal &minCutoffHz, const qreal &beta);
+
+    // Starts a new gesture, point counts as already sent
+    void reset(const QPointF &point = QPointF());
+    void update(const QPointF &point);
+
+signals:
+    void send(QPointF point);
+
+private slots:
+    void onFlushTimeout();
+
+private:
+    QPointF filter(const QPointF &point, const qreal &dt);
+    void sendNow(const QPointF &point, const qint64 &now);
+    void scheduleFlush(const qint64 &now);
+    void updateInterval();
+
+    qreal m_epsilon;
+    // 0 for no cap
+    int m_maxRateHz;
+    int m_sessionRateHz;
+    qint64 m_minIntervalns;
+    qint64 m_restDelayns;
+    // One Euro filter
+    qreal m_minCutoff;
+    qreal m_beta;
+    qreal m_derivativeCutoff;
+    QPointF m_filtered;
+    QPointF m_derivative;
+    bool m_hasSample;
+
+    QPointF m_raw;
+    QPointF m_lastSent;
+    bool m_pending;
+    qint64 m_lastUpdate;
+    qint64 m_lastSendTime;
+    QElapsedTimer m_clock;
+    QTimer m_flushTimer;
+};
+
+#endif // STICKSENDPOLICY_H
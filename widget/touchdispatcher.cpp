@@ -0,0 +1,77 @@
+#include "touchdispatcher.h"
+#include "common/trace.h"
+#include <QTouchEvent>
+
+TouchDispatcher::TouchDispatcher(QWidget *root) : QObject(root), m_root(root) {
+    // Controls don't accept touch themselves, so Qt delivers every point to the root
+    m_root->setAttribute(Qt::WA_AcceptTouchEvents);
+    m_root->installEventFilter(this);
+}
+
+bool TouchDispatcher::eventFilter(QObject *watched, QEvent *event) {
+    TRACE_SCOPE("touch");
+    const QEvent::Type eventType = event->type();
+    if(watched != m_root || (eventType != QEvent::TouchBegin && eventType != QEvent::TouchUpdate && eventType != QEvent::TouchEnd && eventType != QEvent::TouchCancel))
+        return QObject::eventFilter(watched, event);
+
+    if(eventType == QEvent::TouchCancel) {
+        cancelAll();
+        return true;
+    }
+
+    QTouchEvent *touchEvent = static_cast <QTouchEvent*> (event);
+    const bool hasPressure = touchEvent->device() && (touchEvent->device()->capabilities() & QTouchDevice::Pressure);
+    for(const QTouchEvent::TouchPoint &point: touchEvent->touchPoints()) {
+        const Qt::TouchPointState state = point.state();
+        if(state == Qt::TouchPointStationary)
+            continue;
+
+        auto it = m_routes.find(point.id());
+        if(state == Qt::TouchPointPressed) {
+            Route route;
+            if(!this->route(point.pos(), route))
+                continue;
+            it = m_routes.insert(point.id(), route);
+        } else if(it == m_routes.end()) {
+            continue;
+        }
+
+        if(!it->widget) {
+            m_routes.erase(it);
+            continue;
+        }
+        const AbstractTouchControl::TouchPointer pointer = {point.id(), point.pos() - QPointF(it->widget->mapTo(m_root, QPoint(0, 0))), hasPressure ? point.pressure() : -1};
+        if(state == Qt::TouchPointPressed) {
+            it->control->touchBegin(pointer);
+        } else if(state == Qt::TouchPointMoved) {
+            it->control->touchUpdate(pointer);
+        } else if(state == Qt::TouchPointReleased) {
+            it->control->touchEnd(pointer);
+            m_routes.erase(it);
+        }
+    }
+
+    // Accepting TouchBegin is what keeps the updates coming
+    event->accept();
+    return true;
+}
+
+bool TouchDispatcher::route(const QPointF &pos, Route &route) const {
+    for(QWidget *widget = m_root->childAt(pos.toPoint()); widget && widget != m_root; widget = widget->parentWidget()) {
+        AbstractTouchControl *control = dynamic_cast <AbstractTouchControl*> (widget);
+        if(control && widget->isEnabled()) {
+            route.widget = widget;
+            route.control = control;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TouchDispatcher::cancelAll() {
+    for(auto it = m_routes.begin(); it != m_routes.end(); ++it) {
+        if(it->widget)
+            it->control->touchCancel(it.key());
+    }
+    m_routes.clear();
+}
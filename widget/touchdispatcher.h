@@ -0,0 +1,33 @@
+#ifndef TOUCHDISPATCHER_H
+#define TOUCHDISPATCHER_H
+
+#include "widget/abstracttouchcontrol.h"
+#include <QObject>
+#include <QPointer>
+#include <QHash>
+#include <QWidget>
+
+// Receives every touch point of a top level widget and routes each pointer id to the control
+// it landed on at TouchBegin, so several fingers can work the same or different controls
+class TouchDispatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit TouchDispatcher(QWidget *root);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    struct Route {
+        QPointer <QWidget> widget;
+        AbstractTouchControl *control;
+    };
+
+    bool route(const QPointF &pos, Route &route) const;
+    void cancelAll();
+
+    QWidget *m_root;
+    QHash <int, Route> m_routes;
+};
+
+#endif // TOUCHDISPATCHER_H
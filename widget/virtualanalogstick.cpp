@@ -1,12 +1,12 @@
 #include "virtualanalogstick.h"
-#include <QTouchEvent>
+#include "common/trace.h"
+#include "repaintscheduler.h"
+#include <QResizeEvent>
 #include <QPainter>
 #include <QDebug>
 #include <QtMath>
 
-VirtualAnalogStick::VirtualAnalogStick(const Button &btn, QWidget *parent) : m_btn(btn), QWidget(parent), m_touchPoint(this->rect().center()) {
-    setAttribute(Qt::WA_AcceptTouchEvents);
-
+VirtualAnalogStick::VirtualAnalogStick(const Button &btn, QWidget *parent) : m_btn(btn), QWidget(parent), m_pointerId(-1), m_touchPoint(this->rect().center()) {
     m_innerRadius = 50;
     m_outerRadius = 150;
 
@@ -14,14 +14,12 @@ VirtualAnalogStick::VirtualAnalogStick(const Button &btn, QWidget *parent) : m_b
     m_outerColor = QColor(255, 32, 32, 255);
     m_lineWidth = 10;
 
-    m_timer.setInterval(25);
-    m_timer.setSingleShot(true);
-    QWidget::connect(&m_timer, &QTimer::timeout, this, QOverload <>::of (&QWidget::repaint));
-    m_timer.start();
+    QWidget::connect(&m_sendPolicy, &StickSendPolicy::send, [this] (QPointF point) {
+        emit moved(m_btn, point);
+    });
 }
 
 VirtualAnalogStick::~VirtualAnalogStick() {
-    m_timer.stop();
 }
 
 bool VirtualAnalogStick::event(QEvent *event) {
@@ -38,53 +36,58 @@ bool VirtualAnalogStick::event(QEvent *event) {
         setOuterRadius(ro);
         setMask(QRegion(QRect(QPoint(0, 0), resizeEvent->size()), QRegion::Ellipse));
         m_touchPoint = QPointF(w/2, h/2);
-        m_timer.start();
-        return QWidget::event(event);
     }
 
-    if(eventType != QEvent::TouchBegin && eventType != QEvent::TouchUpdate && eventType != QEvent::TouchEnd && eventType != QEvent::TouchCancel) {
-        return QWidget::event(event);
-    }
+    return QWidget::event(event);
+}
 
-    if(!m_timer.isActive()) {
-        m_timer.start();
-    }
+void VirtualAnalogStick::touchBegin(const TouchPointer &pointer) {
+    if(m_pointerId != -1)
+        return;
+    m_pointerId = pointer.id;
+    setTouchPoint(pointer.pos);
+    m_sendPolicy.reset(normalisedTouchPoint());
+    emit pressed(m_btn, normalisedTouchPoint());
+    RepaintScheduler::schedule(this);
+}
+
+void VirtualAnalogStick::touchUpdate(const TouchPointer &pointer) {
+    if(pointer.id != m_pointerId)
+        return;
+    setTouchPoint(pointer.pos);
+    m_sendPolicy.update(normalisedTouchPoint()); // Emits moved when the change is worth sending
+    RepaintScheduler::schedule(this);
+}
 
-    const QTouchEvent *touchEvent = static_cast <const QTouchEvent*> (event);
-
-    switch (event->type()) {
-        case QEvent::TouchEnd: {
-            emit released(m_btn, normalisedTouchPoint());
-            m_touchPoint = this->rect().center();
-            return true;
-        }
-        case QEvent::TouchCancel: {
-            emit released(m_btn, normalisedTouchPoint());
-            m_touchPoint = this->rect().center();
-            return true;
-        }
-        default: {
-            const QPointF rawTouchPoint = touchEvent->touchPoints().first().pos();
-            const QPoint origin = this->rect().center();
-            const qreal maxRadius = m_outerRadius - m_innerRadius;
-            if((rawTouchPoint - origin).manhattanLength() > maxRadius) {
-                const QLineF line(origin, rawTouchPoint.toPoint());
-                const double lineAngle = qDegreesToRadians(360-line.angle());
-                m_touchPoint.setY(qSin(lineAngle) * maxRadius + origin.y());
-                m_touchPoint.setX(qCos(lineAngle) * maxRadius + origin.x());
-            } else {
-                m_touchPoint = rawTouchPoint;
-            }
-
-            if(event->type() == QEvent::TouchBegin)
-                emit pressed(m_btn, normalisedTouchPoint());
-            else if(event->type() == QEvent::TouchUpdate)
-                emit moved(m_btn, normalisedTouchPoint());
-
-            return true;
-        }
+void VirtualAnalogStick::touchEnd(const TouchPointer &pointer) {
+    if(pointer.id == m_pointerId)
+        release();
+}
+
+void VirtualAnalogStick::touchCancel(const int &id) {
+    if(id == m_pointerId)
+        release();
+}
+
+void VirtualAnalogStick::setTouchPoint(const QPointF &rawTouchPoint) {
+    const QPoint origin = this->rect().center();
+    const qreal maxRadius = m_outerRadius - m_innerRadius;
+    if((rawTouchPoint - origin).manhattanLength() > maxRadius) {
+        const QLineF line(origin, rawTouchPoint.toPoint());
+        const double lineAngle = qDegreesToRadians(360-line.angle());
+        m_touchPoint.setY(qSin(lineAngle) * maxRadius + origin.y());
+        m_touchPoint.setX(qCos(lineAngle) * maxRadius + origin.x());
+    } else {
+        m_touchPoint = rawTouchPoint;
     }
+}
 
+void VirtualAnalogStick::release() {
+    m_pointerId = -1;
+    m_sendPolicy.reset();
+    emit released(m_btn, normalisedTouchPoint());
+    m_touchPoint = this->rect().center();
+    RepaintScheduler::schedule(this);
 }
 
 QPointF VirtualAnalogStick::touchPoint() const {
@@ -96,6 +99,7 @@ inline QPointF VirtualAnalogStick::normalisedTouchPoint() const {
 }
 
 void VirtualAnalogStick::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE("paint stick");
     QPainter painter(this);
 
     QPen pen = painter.pen();
@@ -184,6 +188,10 @@ void VirtualAnalogStick::setInnerColor(const QColor &innerColor)
     m_innerColor = innerColor;
 }
 
+StickSendPolicy *VirtualAnalogStick::sendPolicy() {
+    return &m_sendPolicy;
+}
+
 QSize VirtualAnalogStick::minimumSizeHint() const {
     return QSize(m_outerRadius * 2, m_outerRadius * 2);
 }
@@ -2,10 +2,11 @@
 #define VIRTUALANALOGSTICK_H
 
 #include "common/common.h"
+#include "widget/sticksendpolicy.h"
+#include "widget/abstracttouchcontrol.h"
 #include <QWidget>
-#include <QTimer>
 
-class VirtualAnalogStick : public QWidget {
+class VirtualAnalogStick : public QWidget, public AbstractTouchControl {
     Q_OBJECT
 
 public:
@@ -30,6 +31,13 @@ public:
     qreal innerRadius() const;
     void setInnerRadius(const qreal &innerRadius);
 
+    StickSendPolicy *sendPolicy();
+
+    void touchBegin(const TouchPointer &pointer) override;
+    void touchUpdate(const TouchPointer &pointer) override;
+    void touchEnd(const TouchPointer &pointer) override;
+    void touchCancel(const int &id) override;
+
 signals:
     void moved(Button btn, QPointF normalisedTouchPoint);
     void pressed(Button btn, QPointF normalisedTouchPoint);
@@ -41,7 +49,12 @@ protected:
     int heightForWidth(int) const override;
 
 private:
+    void setTouchPoint(const QPointF &rawTouchPoint);
+    void release();
+
     Button m_btn;
+    // The finger that grabbed the stick, others landing on it are ignored
+    int m_pointerId;
     qreal m_outerRadius;
     qreal m_innerRadius;
 
@@ -52,7 +65,7 @@ private:
     QPointF m_touchPoint;
     QRect m_innerRect;
 
-    QTimer m_timer;
+    StickSendPolicy m_sendPolicy;
 };
 
 #endif // VIRTUALANALOGSTICK_H
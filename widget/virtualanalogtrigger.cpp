@@ -0,0 +1,112 @@
+#include "virtualanalogtrigger.h"
+#include "common/trace.h"
+#include "repaintscheduler.h"
+#include "event/gamepadevent.h"
+#include <QPainter>
+#include <QtMath>
+
+VirtualAnalogTrigger::VirtualAnalogTrigger(const Button &btn, QWidget *parent) : QWidget(parent), m_btn(btn), m_pointerId(-1), m_originY(0), m_value(0) {
+    m_fillColor = QColor(255, 32, 32, 255);
+    m_frameColor = QColor(32, 32, 32, 128);
+    m_lineWidth = 6;
+}
+
+VirtualAnalogTrigger::~VirtualAnalogTrigger() {
+}
+
+void VirtualAnalogTrigger::touchBegin(const TouchPointer &pointer) {
+    if(m_pointerId != -1)
+        return;
+    m_pointerId = pointer.id;
+    m_originY = pointer.pos.y();
+    emit pressed(m_btn);
+    sample(pointer);
+}
+
+void VirtualAnalogTrigger::touchUpdate(const TouchPointer &pointer) {
+    if(pointer.id == m_pointerId)
+        sample(pointer);
+}
+
+void VirtualAnalogTrigger::touchEnd(const TouchPointer &pointer) {
+    if(pointer.id == m_pointerId)
+        release();
+}
+
+void VirtualAnalogTrigger::touchCancel(const int &id) {
+    if(id == m_pointerId)
+        release();
+}
+
+void VirtualAnalogTrigger::sample(const TouchPointer &pointer) {
+    qreal amount;
+    if(pointer.pressure >= 0) {
+        amount = pointer.pressure;
+    } else {
+        // Sliding down the remaining height of the trigger pulls it all the way
+        const qreal travel = height() - m_originY;
+        amount = travel > 0 ? (pointer.pos.y() - m_originY) / travel : 1;
+    }
+    amount = qBound(qreal(0), amount, qreal(1));
+
+    const int value = qRound(amount * GamepadEvent::TriggerMax);
+    if(value == m_value)
+        return;
+    m_value = value;
+    emit moved(m_btn, m_value);
+    RepaintScheduler::schedule(this);
+}
+
+void VirtualAnalogTrigger::release() {
+    m_pointerId = -1;
+    if(m_value != 0) {
+        m_value = 0;
+        emit moved(m_btn, m_value);
+    }
+    emit released(m_btn);
+    RepaintScheduler::schedule(this);
+}
+
+void VirtualAnalogTrigger::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE("paint trigger");
+    QPainter painter(this);
+
+    const QRectF frame = QRectF(rect()).adjusted(m_lineWidth/2, m_lineWidth/2, -m_lineWidth/2, -m_lineWidth/2);
+
+    // Fill grows from the top, like a trigger being pulled
+    if(m_value > 0) {
+        QRectF fill = frame;
+        fill.setHeight(frame.height() * m_value / GamepadEvent::TriggerMax);
+        painter.fillRect(fill, m_fillColor);
+    }
+
+    QPen pen = painter.pen();
+    pen.setWidth(m_lineWidth);
+    pen.setColor(m_frameColor);
+    painter.setPen(pen);
+    painter.drawRect(frame);
+}
+
+int VirtualAnalogTrigger::value() const {
+    return m_value;
+}
+
+QColor VirtualAnalogTrigger::fillColor() const {
+    return m_fillColor;
+}
+
+void VirtualAnalogTrigger::setFillColor(const QColor &fillColor) {
+    m_fillColor = fillColor;
+}
+
+QColor VirtualAnalogTrigger::frameColor() const {
+    return m_frameColor;
+}
+
+void VirtualAnalogTrigger::setFrameColor(const QColor &frameColor) {
+    m_frameColor = frameColor;
+}
+
+QSize VirtualAnalogTrigger::minimumSizeHint() const {
+    return QSize(50, 100);
+}
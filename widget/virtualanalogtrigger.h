@@ -0,0 +1,59 @@
+#ifndef VIRTUALANALOGTRIGGER_H
+#define VIRTUALANALOGTRIGGER_H
+
+#include "common/common.h"
+#include "widget/abstracttouchcontrol.h"
+#include <QWidget>
+#include <QColor>
+
+// Analog trigger, the value comes from touch pressure when the device reports it,
+// otherwise from how far the finger slid down the trigger
+class VirtualAnalogTrigger : public QWidget, public AbstractTouchControl {
+    Q_OBJECT
+
+public:
+    explicit VirtualAnalogTrigger(const Button &btn, QWidget *parent = nullptr);
+    ~VirtualAnalogTrigger();
+
+    QSize minimumSizeHint() const override;
+
+    // Quantized value in [0, GamepadEvent::TriggerMax], the resolution the driver scales by
+    int value() const;
+
+    QColor fillColor() const;
+    void setFillColor(const QColor &fillColor);
+
+    QColor frameColor() const;
+    void setFrameColor(const QColor &frameColor);
+
+    void touchBegin(const TouchPointer &pointer) override;
+    void touchUpdate(const TouchPointer &pointer) override;
+    void touchEnd(const TouchPointer &pointer) override;
+    void touchCancel(const int &id) override;
+
+signals:
+    void pressed(Button btn);
+    void released(Button btn);
+    // Only emitted when the quantized value changes
+    void moved(Button btn, int value);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    void sample(const TouchPointer &pointer);
+    void release();
+
+    Button m_btn;
+    // The finger that grabbed the trigger, others landing on it are ignored
+    int m_pointerId;
+    // Where the finger landed, travel is measured from there
+    qreal m_originY;
+    int m_value;
+
+    qreal m_lineWidth;
+    QColor m_fillColor;
+    QColor m_frameColor;
+};
+
+#endif // VIRTUALANALOGTRIGGER_H
@@ -1,29 +1,28 @@
 #include "virtualdirectionalpad.h"
+#include "common/trace.h"
+#include "repaintscheduler.h"
+#include "common/iconatlas.h"
 #include <QEvent>
-#include <QTouchEvent>
+#include <QResizeEvent>
 #include <QtMath>
 #include <QPainter>
 #include <QDebug>
 
-VirtualDirectionalPad::VirtualDirectionalPad(QWidget *parent) : QWidget(parent) {
-    setAttribute(Qt::WA_AcceptTouchEvents);
-
-    m_increment = 90;
-    m_startAngle = 0;
-    m_endAngle = 360;
-    m_offset = -m_increment/2;
+namespace {
+const quint32 Directions = Button::UP | Button::DOWN | Button::LEFT | Button::RIGHT;
+}
 
+VirtualDirectionalPad::VirtualDirectionalPad(QWidget *parent) : QWidget(parent), m_pointerId(-1) {
     m_outerRadius = 100;
-    m_innerRadius = m_outerRadius/3;
+    m_deadzone = 1.0/6;
+    m_innerRadius = m_outerRadius * m_deadzone;
+    m_mode = Mode::FourWay;
     m_pressedButtons = Button::DPAD;
+    buildSectors();
 
-    // Transitional region [315, 45] broken up into two pieces because no positive angle could between these two values
-    m_regions.push_back(DpadRegion(315, 360, Button::RIGHT));
-    m_regions.push_back(DpadRegion(0, 45, Button::RIGHT));
-    // Rest are all positive values
-    m_regions.push_back(DpadRegion(1 * m_increment + m_offset, 2 * m_increment + m_offset, Button::DOWN));
-    m_regions.push_back(DpadRegion(2 * m_increment + m_offset, 3 * m_increment + m_offset, Button::LEFT));
-    m_regions.push_back(DpadRegion(3 * m_increment + m_offset, 4 * m_increment + m_offset, Button::UP));
+    connect(IconAtlas::instance(), &IconAtlas::spriteReady, this, [this] () {
+        RepaintScheduler::schedule(this);
+    });
 }
 
 VirtualDirectionalPad::~VirtualDirectionalPad() {
@@ -33,79 +32,123 @@ QSize VirtualDirectionalPad::minimumSizeHint() const {
     return QSize(100, 100);
 }
 
+VirtualDirectionalPad::Mode VirtualDirectionalPad::mode() const {
+    return m_mode;
+}
+
+void VirtualDirectionalPad::setMode(const Mode &mode) {
+    m_mode = mode;
+    buildSectors();
+}
+
+qreal VirtualDirectionalPad::deadzone() const {
+    return m_deadzone;
+}
+
+void VirtualDirectionalPad::setDeadzone(const qreal &deadzone) {
+    m_deadzone = deadzone;
+    m_innerRadius = width() * m_deadzone;
+}
+
+void VirtualDirectionalPad::buildSectors() {
+    // Four way splits the circle in 90 degree quadrants centered on the axes, eight way adds
+    // 45 degree diagonals. Both boundaries fall exactly on sector edges for 64 sectors
+    const quint32 fourWay[] = {Button::RIGHT, Button::DOWN, Button::LEFT, Button::UP};
+    const quint32 eightWay[] = {Button::RIGHT, Button::RIGHT | Button::DOWN, Button::DOWN, Button::DOWN | Button::LEFT,
+                                Button::LEFT, Button::LEFT | Button::UP, Button::UP, Button::UP | Button::RIGHT};
+    for(int i = 0; i < SectorCount; ++i) {
+        const qreal angle = (i + 0.5) * 360 / SectorCount;
+        if(m_mode == Mode::FourWay)
+            m_sectors[i] = fourWay[int((angle + 45) / 90) % 4];
+        else
+            m_sectors[i] = eightWay[int((angle + 22.5) / 45) % 8];
+    }
+}
+
+quint32 VirtualDirectionalPad::hitTest(const QPointF &point) const {
+    const QPointF delta = point - QRectF(rect()).center();
+    if(QPointF::dotProduct(delta, delta) < m_innerRadius * m_innerRadius)
+        return Button::DPAD;
+    // y grows downwards so the angle runs clockwise on screen
+    qreal angle = qAtan2(delta.y(), delta.x());
+    if(angle < 0)
+        angle += 2 * M_PI;
+    return m_sectors[int(angle * SectorCount / (2 * M_PI)) & (SectorCount - 1)];
+}
+
+void VirtualDirectionalPad::setPressedButtons(const quint32 &buttons) {
+    const quint32 previous = m_pressedButtons;
+    m_pressedButtons = buttons;
+    if(previous == buttons)
+        return;
+
+    // Emit first, painting only gets scheduled. One signal per direction so diagonals
+    // reach the driver as two ordinary buttons
+    const quint32 released = previous & ~buttons & Directions;
+    const quint32 pressed = buttons & ~previous & Directions;
+    for(quint32 bit = Button::UP; bit <= Button::RIGHT; bit <<= 1) {
+        if(released & bit)
+            emit this->released(Button(bit));
+    }
+    for(quint32 bit = Button::UP; bit <= Button::RIGHT; bit <<= 1) {
+        if(pressed & bit)
+            emit this->pressed(Button(bit));
+    }
+    RepaintScheduler::schedule(this);
+}
+
 bool VirtualDirectionalPad::event(QEvent *event) {
     QEvent::Type eventType = event->type();
 
     if(eventType == QEvent::Resize) {
         const QResizeEvent *resizeEvent = static_cast <const QResizeEvent*> (event);
         m_outerRadius = sqrt(resizeEvent->size().width() * resizeEvent->size().width());
-        m_innerRadius = resizeEvent->size().width()/6;
-        return QWidget::event(event);
-    }
-
-    if(eventType != QEvent::TouchBegin && eventType != QEvent::TouchUpdate && eventType != QEvent::TouchEnd && eventType != QEvent::TouchCancel) {
-        return QWidget::event(event);
+        m_innerRadius = resizeEvent->size().width() * m_deadzone;
     }
 
-    const QTouchEvent *touchEvent = static_cast <const QTouchEvent*> (event);
+    return QWidget::event(event);
+}
 
-    if(touchEvent->target() != this) {
-        return QWidget::event(event);
-    }
+void VirtualDirectionalPad::touchBegin(const TouchPointer &pointer) {
+    if(m_pointerId != -1)
+        return;
+    m_pointerId = pointer.id;
+    setPressedButtons(hitTest(pointer.pos));
+}
 
-    if(!m_timer.isActive()) {
-        m_timer.start();
-    }
+void VirtualDirectionalPad::touchUpdate(const TouchPointer &pointer) {
+    if(pointer.id == m_pointerId)
+        setPressedButtons(hitTest(pointer.pos));
+}
 
-    // DETERMINE WHICH REGION WAS TOUCHED
-    const QPointF rawTouchPoint = touchEvent->touchPoints().first().pos();
-    const QPoint origin = this->rect().center();
-    const QLineF line(origin, rawTouchPoint.toPoint());
-    const qreal lineAngle = 360-line.angle();
-    for(DpadRegion region: m_regions) {
-        if(region.startAngle < lineAngle && lineAngle <= region.endAngle) {
-            m_pressedButtons = region.pressedButtons;
-            break;
-        }
-    }
+void VirtualDirectionalPad::touchEnd(const TouchPointer &pointer) {
+    touchCancel(pointer.id);
+}
 
-    if(m_pressedButtons != m_pressedButtonsPrevious)
-        repaint();
-    m_pressedButtonsPrevious = m_pressedButtons;
-
-    switch (event->type()) {
-        case QEvent::TouchEnd: {
-            if(m_pressedButtons != Button::DPAD)
-                emit released((Button)m_pressedButtons);
-            m_pressedButtons = Button::DPAD;
-            repaint();
-            return true;
-        }
-        case QEvent::TouchCancel: {
-            if(m_pressedButtons != Button::DPAD)
-                emit released((Button)m_pressedButtons);
-            m_pressedButtons = Button::DPAD;
-            repaint();
-            return true;
-        }
-        case QEvent::TouchBegin: {
-            if(m_pressedButtons != Button::DPAD)
-                emit pressed((Button)m_pressedButtons);
-            repaint();
-            return true;
-        }
-        default: {
-            return true;
-        }
-    }
+void VirtualDirectionalPad::touchCancel(const int &id) {
+    if(id != m_pointerId)
+        return;
+    m_pointerId = -1;
+    setPressedButtons(Button::DPAD);
 }
 
 void VirtualDirectionalPad::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE("paint dpad");
     QPainter painter(this);
-
-    QSharedPointer<QPixmap> pixmap = Common::buttonIcon(m_pressedButtons, rect().size());
-    if(!pixmap.isNull())
-        painter.drawPixmap(rect(), *pixmap);
+    if(m_pressedButtons == Button::DPAD) {
+        const IconAtlas::Sprite sprite = IconAtlas::instance()->sprite(Button::DPAD, IconAtlas::Released, rect().size());
+        if(!sprite.isNull())
+            painter.drawImage(rect(), sprite.page, sprite.rect);
+        return;
+    }
+    // Diagonals layer the icons of both directions
+    for(quint32 bit = Button::UP; bit <= Button::RIGHT; bit <<= 1) {
+        if(!(m_pressedButtons & bit))
+            continue;
+        const IconAtlas::Sprite sprite = IconAtlas::instance()->sprite(bit, IconAtlas::Pressed, rect().size());
+        if(!sprite.isNull())
+            painter.drawImage(rect(), sprite.page, sprite.rect);
+    }
 }
 
 int VirtualDirectionalPad::heightForWidth(int w) const {
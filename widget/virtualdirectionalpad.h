@@ -2,19 +2,36 @@
 #define VIRTUALDIRECTIONALPAD_H
 
 #include <QWidget>
-#include <QTimer>
 #include <QPixmap>
 #include <QMap>
 #include "common/common.h"
+#include "widget/abstracttouchcontrol.h"
 
-class VirtualDirectionalPad : public QWidget {
+class VirtualDirectionalPad : public QWidget, public AbstractTouchControl {
     Q_OBJECT
 public:
+    enum Mode {
+        FourWay,
+        EightWay,
+    };
+
     explicit VirtualDirectionalPad(QWidget *parent = nullptr);
     ~VirtualDirectionalPad();
 
     QSize minimumSizeHint() const override;
 
+    Mode mode() const;
+    void setMode(const Mode &mode);
+
+    // Radius of the neutral center as a fraction of the width
+    qreal deadzone() const;
+    void setDeadzone(const qreal &deadzone);
+
+    void touchBegin(const TouchPointer &pointer) override;
+    void touchUpdate(const TouchPointer &pointer) override;
+    void touchEnd(const TouchPointer &pointer) override;
+    void touchCancel(const int &id) override;
+
 signals:
     void pressed(Button buttons);
     void released(Button buttons);
@@ -25,29 +42,24 @@ protected:
     int heightForWidth(int) const override;
 
 private:
-    QTimer m_timer;
-    QPointF m_touchPoint;
+    void buildSectors();
+    quint32 hitTest(const QPointF &point) const;
+    void setPressedButtons(const quint32 &buttons);
+
+    // Only the first finger on the pad steers it
+    int m_pointerId;
 
     // Paramaters defining the click regions
     int m_outerRadius;
     int m_innerRadius;
-    qreal m_increment;
-    qreal m_startAngle;
-    qreal m_endAngle;
-    qreal m_offset;
-
-    struct DpadRegion {
-        DpadRegion(qreal startAngle, qreal endAngle, quint32 pressedButtons): startAngle(startAngle), endAngle(endAngle), pressedButtons(pressedButtons) {
-        }
-        qreal startAngle;
-        qreal endAngle;
-        quint32 pressedButtons;
-    };
-    QVector <DpadRegion> m_regions;
+    qreal m_deadzone;
+    Mode m_mode;
+    // Buttons pressed per angle sector, clockwise from the positive x axis
+    static const int SectorCount = 64;
+    quint32 m_sectors[SectorCount];
 
     // Button state
     quint32 m_pressedButtons;
-    quint32 m_pressedButtonsPrevious;
 };
 
 #endif // VIRTUALDIRECTIONALPAD_H
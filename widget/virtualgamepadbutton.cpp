@@ -1,14 +1,18 @@
 #include "virtualgamepadbutton.h"
+#include "common/trace.h"
+#include "repaintscheduler.h"
+#include "common/iconatlas.h"
 #include <QPixmap>
 #include <QPainter>
-#include <QTouchEvent>
 #include <QResizeEvent>
 #include <QEvent>
 
 VirtualGamepadButton::VirtualGamepadButton(const Button &btn, QWidget *parent) : QWidget(parent), m_button(btn), m_pressed(false) {
-    setAttribute(Qt::WA_AcceptTouchEvents);
     m_pressedScale = 0.8;
     m_releasedScale = 0.9;
+    connect(IconAtlas::instance(), &IconAtlas::spriteReady, this, [this] () {
+        RepaintScheduler::schedule(this);
+    });
 }
 
 VirtualGamepadButton::~VirtualGamepadButton() {
@@ -19,9 +23,6 @@ bool VirtualGamepadButton::event(QEvent *event) {
 
     if(eventType == QEvent::Resize) {
         const QResizeEvent *resizeEvent = static_cast <const QResizeEvent*> (event);
-        // Get icons
-        m_pixmap = Common::buttonIcon(m_button, resizeEvent->size() * m_releasedScale);
-        m_pixmapPressed = Common::buttonIcon(m_button, resizeEvent->size() * m_pressedScale);
         // Set rects
         const QRect rect = QRect(QPoint(0, 0), resizeEvent->size());
         {
@@ -38,53 +39,53 @@ bool VirtualGamepadButton::event(QEvent *event) {
             const int sH = rect.height() * m_pressedScale;
             m_pressedRect = QRect(sX, sY, sW, sH);
         }
-
-        // Return base implementation result
-        return QWidget::event(event);
+        // Warm up the atlas for both states, rendering happens in the background
+        IconAtlas::instance()->sprite(m_button, IconAtlas::Released, m_releasedRect.size());
+        IconAtlas::instance()->sprite(m_button, IconAtlas::Pressed, m_pressedRect.size());
     }
 
-    if(eventType != QEvent::TouchBegin && eventType != QEvent::TouchUpdate && eventType != QEvent::TouchEnd && eventType != QEvent::TouchCancel) {
-        return QWidget::event(event);
-    }
+    // Return base implementation result
+    return QWidget::event(event);
+}
 
-//    const QTouchEvent *touchEvent = static_cast <const QTouchEvent*> (event);
+void VirtualGamepadButton::touchBegin(const TouchPointer &pointer) {
+    m_pointers.insert(pointer.id);
+    if(m_pressed)
+        return;
+    emit pressed(m_button);
+    m_pressed = true;
+    RepaintScheduler::schedule(this);
+}
 
-    switch (event->type()) {
-        case QEvent::TouchEnd: {
-            emit released(m_button);
-            m_pressed = false;
-            repaint();
-            return true;
-        }
-        case QEvent::TouchCancel: {
-            m_pressed = false;
-            repaint();
-            return true;
-        }
-        case QEvent::TouchBegin: {
-            emit pressed(m_button);
-            m_pressed = true;
-            repaint();
-            return true;
-        }
-        default: {
-            return true;
-        }
-    }
+void VirtualGamepadButton::touchUpdate(const TouchPointer &pointer) {
+}
 
+void VirtualGamepadButton::touchEnd(const TouchPointer &pointer) {
+    removePointer(pointer.id);
+}
+
+void VirtualGamepadButton::touchCancel(const int &id) {
+    removePointer(id);
+}
+
+void VirtualGamepadButton::removePointer(const int &id) {
+    m_pointers.remove(id);
+    if(!m_pressed || !m_pointers.isEmpty())
+        return;
+    emit released(m_button);
+    m_pressed = false;
+    RepaintScheduler::schedule(this);
 }
 
 void VirtualGamepadButton::paintEvent(QPaintEvent *event) {
-    if(m_pixmap.isNull())
+    TRACE_SCOPE("paint button");
+    const QRect &rect = m_pressed ? m_pressedRect : m_releasedRect;
+    const IconAtlas::Sprite sprite = IconAtlas::instance()->sprite(m_button, m_pressed ? IconAtlas::Pressed : IconAtlas::Released, rect.size());
+    if(sprite.isNull())
         return;
 
     QPainter painter(this);
-    if(!m_pressed) {
-        painter.drawPixmap(m_releasedRect, *m_pixmap);
-    }
-    else {
-        painter.drawPixmap(m_pressedRect, *m_pixmapPressed);
-    }
+    painter.drawImage(rect, sprite.page, sprite.rect);
 }
 
 int VirtualGamepadButton::heightForWidth(int w) const {
@@ -2,14 +2,21 @@
 #define VIRTUALGAMEPADBUTTON_H
 
 #include <QWidget>
+#include <QSet>
 #include "common/common.h"
+#include "widget/abstracttouchcontrol.h"
 
-class VirtualGamepadButton : public QWidget {
+class VirtualGamepadButton : public QWidget, public AbstractTouchControl {
     Q_OBJECT
 public:
     explicit VirtualGamepadButton(const Button &btn, QWidget *parent = nullptr);
     ~VirtualGamepadButton();
 
+    void touchBegin(const TouchPointer &pointer) override;
+    void touchUpdate(const TouchPointer &pointer) override;
+    void touchEnd(const TouchPointer &pointer) override;
+    void touchCancel(const int &id) override;
+
 signals:
     void pressed(const Button &btn);
     void released(const Button &btn);
@@ -21,10 +28,12 @@ protected:
     QSize minimumSizeHint() const override;
 
 private:
+    void removePointer(const int &id);
+
+    // Held down as long as any finger is on it
+    QSet <int> m_pointers;
     bool m_pressed;
     Button m_button;
-    QSharedPointer <QPixmap> m_pixmap;
-    QSharedPointer <QPixmap> m_pixmapPressed;
     qreal m_pressedScale;
     qreal m_releasedScale;
     QRect m_pressedRect;